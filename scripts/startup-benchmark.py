@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Measures nm-applet cold-start latency against a mock NetworkManager.
+#
+# Every run starts a fresh nm-applet with --startup-timing on private system
+# and session buses, where python-dbusmock plays NetworkManager, and collects
+# the "startup:" phases it logs. Needs python-dbusmock and a display; run it
+# under xvfb-run when there is none:
+#
+#   xvfb-run scripts/startup-benchmark.py --applet build/src/nm-applet
+#
+# "ninja startup-benchmark" or "make startup-benchmark" does the same.
+
+import argparse
+import os
+import re
+import selectors
+import statistics
+import subprocess
+import sys
+import time
+
+try:
+    import dbus
+    import dbusmock
+except ImportError as e:
+    sys.exit('startup-benchmark needs python-dbusmock: %s' % e)
+
+PHASE_RE = re.compile(r'startup: (.+?)\s+([0-9.]+) ms \(\+([0-9.]+) ms\)')
+CLIENT_RE = re.compile(r'startup: NMClient took ([0-9.]+) ms')
+
+# The applet is up once these are logged; "client ready" comes from the
+# asynchronous NMClient creation and may arrive after "startup done".
+DEFAULT_UNTIL = ['startup done', 'client ready', 'first icon']
+
+
+def setup_mock_nm(n_aps):
+    nm, nm_obj = dbusmock.DBusTestCase.spawn_server_template(
+        'networkmanager', {'NetworkingEnabled': True},
+        stdout=subprocess.DEVNULL)
+    mock = dbus.Interface(nm_obj, dbusmock.MOCK_IFACE)
+
+    mock.AddEthernetDevice('mock_Ethernet1', 'eth0', 100)
+    if n_aps > 0:
+        wifi = mock.AddWiFiDevice('mock_WiFi1', 'wlan0', 100)
+        for i in range(n_aps):
+            mock.AddAccessPoint(wifi, 'Mock_AP%d' % i, 'ssid%d' % i,
+                                '00:23:f8:7e:%02x:%02x' % (i >> 8, i & 0xff),
+                                2, 2425, 5400, 82, 0x400)
+    return nm
+
+
+def run_applet(args):
+    cmd = [args.applet, '--startup-timing']
+    if not args.agent:
+        cmd.append('--no-agent')
+
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE, text=True)
+    sel = selectors.DefaultSelector()
+    sel.register(proc.stderr, selectors.EVENT_READ)
+
+    phases = {}
+    client = None
+    deadline = time.monotonic() + args.timeout
+    try:
+        while not all(p in phases for p in args.until):
+            left = deadline - time.monotonic()
+            if left <= 0 or not sel.select(left):
+                raise RuntimeError('timed out, got phases: %s'
+                                   % (', '.join(phases) or 'none'))
+            line = proc.stderr.readline()
+            if not line:
+                raise RuntimeError('nm-applet exited with status %s'
+                                   % proc.wait())
+            if args.verbose:
+                sys.stderr.write(line)
+            m = PHASE_RE.search(line)
+            if m:
+                phases.setdefault(m.group(1), float(m.group(2)))
+                continue
+            m = CLIENT_RE.search(line)
+            if m:
+                client = float(m.group(1))
+    finally:
+        sel.close()
+        proc.terminate()
+        try:
+            proc.wait(5)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+        proc.stderr.close()
+
+    return phases, client
+
+
+def report(runs, clients):
+    order = []
+    for phases in runs:
+        for p in phases:
+            if p not in order:
+                order.append(p)
+    order.sort(key=lambda p: statistics.median(r[p] for r in runs if p in r))
+
+    print('%-20s %10s %10s %10s' % ('phase (ms)', 'median', 'min', 'max'))
+    for p in order:
+        t = [r[p] for r in runs if p in r]
+        print('%-20s %10.1f %10.1f %10.1f'
+              % (p, statistics.median(t), min(t), max(t)))
+    if clients:
+        print('%-20s %10.1f %10.1f %10.1f'
+              % ('NMClient', statistics.median(clients),
+                 min(clients), max(clients)))
+
+    cold = [r['first icon'] for r in runs if 'first icon' in r]
+    if cold:
+        print('\ncold start (first icon): %.1f ms median over %d runs'
+              % (statistics.median(cold), len(cold)))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Measure nm-applet startup against a mock NetworkManager')
+    parser.add_argument('--applet', default='nm-applet',
+                        help='nm-applet binary to run (default: %(default)s)')
+    parser.add_argument('--runs', type=int, default=10,
+                        help='number of applet starts (default: %(default)s)')
+    parser.add_argument('--access-points', type=int, default=20,
+                        help='mock Wi-Fi access points (default: %(default)s)')
+    parser.add_argument('--timeout', type=float, default=30,
+                        help='seconds to wait for each start (default: %(default)s)')
+    parser.add_argument('--until', action='append',
+                        help='phase to wait for, may be repeated '
+                             '(default: %s)' % ', '.join(DEFAULT_UNTIL))
+    parser.add_argument('--agent', action='store_true',
+                        help='also register the secret agent')
+    parser.add_argument('--verbose', action='store_true',
+                        help='pass the applet log through')
+    args = parser.parse_args()
+    args.until = args.until or DEFAULT_UNTIL
+
+    if not os.environ.get('DISPLAY') and not os.environ.get('WAYLAND_DISPLAY'):
+        sys.exit('startup-benchmark needs a display, try running it under xvfb-run')
+
+    dbusmock.DBusTestCase.start_system_bus()
+    dbusmock.DBusTestCase.start_session_bus()
+    nm = setup_mock_nm(args.access_points)
+
+    runs = []
+    clients = []
+    try:
+        for i in range(args.runs):
+            phases, client = run_applet(args)
+            runs.append(phases)
+            if client is not None:
+                clients.append(client)
+    except RuntimeError as e:
+        sys.exit('run %d: %s' % (len(runs) + 1, e))
+    finally:
+        nm.terminate()
+        nm.wait()
+        dbusmock.DBusTestCase.tearDownClass()
+
+    report(runs, clients)
+
+
+if __name__ == '__main__':
+    main()
@@ -29,7 +29,7 @@ typedef struct {
 
 	char *      ssid_string;
 	guint32     int_strength;
-	gchar *     hash;
+	UtilsApKey  key;
 	GSList *    dupes;
 	gboolean    has_connections;
 	gboolean    is_adhoc;
@@ -150,12 +150,12 @@ nm_network_menu_item_set_strength (NMNetworkMenuItem *item,
 	}
 }
 
-const char *
-nm_network_menu_item_get_hash (NMNetworkMenuItem *item)
+const UtilsApKey *
+nm_network_menu_item_get_key (NMNetworkMenuItem *item)
 {
 	g_return_val_if_fail (NM_IS_NETWORK_MENU_ITEM (item), NULL);
 
-	return NM_NETWORK_MENU_ITEM_GET_PRIVATE (item)->hash;
+	return &NM_NETWORK_MENU_ITEM_GET_PRIVATE (item)->key;
 }
 
 gboolean
@@ -216,6 +216,36 @@ nm_network_menu_item_add_dupe (NMNetworkMenuItem *item, NMAccessPoint *ap)
 	priv->dupes = g_slist_prepend (priv->dupes, g_strdup (path));
 }
 
+gboolean
+nm_network_menu_item_remove_dupe (NMNetworkMenuItem *item, NMAccessPoint *ap)
+{
+	NMNetworkMenuItemPrivate *priv;
+	const char *path;
+	GSList *iter;
+
+	g_return_val_if_fail (NM_IS_NETWORK_MENU_ITEM (item), FALSE);
+	g_return_val_if_fail (NM_IS_ACCESS_POINT (ap), FALSE);
+
+	priv = NM_NETWORK_MENU_ITEM_GET_PRIVATE (item);
+	path = nm_object_get_path (NM_OBJECT (ap));
+	for (iter = priv->dupes; iter; iter = g_slist_next (iter)) {
+		if (!strcmp (path, iter->data)) {
+			g_free (iter->data);
+			priv->dupes = g_slist_delete_link (priv->dupes, iter);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+gboolean
+nm_network_menu_item_is_empty (NMNetworkMenuItem *item)
+{
+	g_return_val_if_fail (NM_IS_NETWORK_MENU_ITEM (item), TRUE);
+
+	return NM_NETWORK_MENU_ITEM_GET_PRIVATE (item)->dupes == NULL;
+}
+
 gboolean
 nm_network_menu_item_get_has_connections (NMNetworkMenuItem *item)
 {
@@ -245,7 +275,7 @@ nm_network_menu_item_get_is_encrypted (NMNetworkMenuItem *item)
 GtkWidget *
 nm_network_menu_item_new (NMAccessPoint *ap,
                           guint32 dev_caps,
-                          const char *hash,
+                          const UtilsApKey *key,
                           gboolean has_connections,
                           NMApplet *applet)
 {
@@ -270,7 +300,7 @@ nm_network_menu_item_new (NMAccessPoint *ap,
 		priv->ssid_string = g_strdup ("<unknown>");
 
 	priv->has_connections = has_connections;
-	priv->hash = g_strdup (hash);
+	priv->key = *key;
 	priv->int_strength = nm_access_point_get_strength (ap);
 
 	if (nm_access_point_get_mode (ap) == NM_802_11_MODE_ADHOC)
@@ -327,7 +357,6 @@ finalize (GObject *object)
 {
 	NMNetworkMenuItemPrivate *priv = NM_NETWORK_MENU_ITEM_GET_PRIVATE (object);
 
-	g_free (priv->hash);
 	g_free (priv->ssid_string);
 
 	g_slist_free_full (priv->dupes, g_free);
@@ -13,6 +13,7 @@
 #include <gtk/gtk.h>
 #include "applet.h"
 #include "nm-access-point.h"
+#include "utils.h"
 
 #define NM_TYPE_NETWORK_MENU_ITEM            (nm_network_menu_item_get_type ())
 #define NM_NETWORK_MENU_ITEM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_NETWORK_MENU_ITEM, NMNetworkMenuItem))
@@ -37,7 +38,7 @@ struct _NMNetworkMenuItemClass {
 GType	   nm_network_menu_item_get_type (void) G_GNUC_CONST;
 GtkWidget* nm_network_menu_item_new (NMAccessPoint *ap,
                                      guint32 dev_caps,
-                                     const char *hash,
+                                     const UtilsApKey *key,
                                      gboolean has_connections,
                                      NMApplet *applet);
 
@@ -50,7 +51,7 @@ guint32    nm_network_menu_item_get_strength (NMNetworkMenuItem *item);
 void       nm_network_menu_item_set_strength (NMNetworkMenuItem *item,
                                               guint8 strength,
                                               NMApplet *applet);
-const char *nm_network_menu_item_get_hash (NMNetworkMenuItem * item);
+const UtilsApKey *nm_network_menu_item_get_key (NMNetworkMenuItem *item);
 
 gboolean   nm_network_menu_item_find_dupe (NMNetworkMenuItem *item,
                                            NMAccessPoint *ap);
@@ -58,6 +59,11 @@ gboolean   nm_network_menu_item_find_dupe (NMNetworkMenuItem *item,
 void       nm_network_menu_item_add_dupe (NMNetworkMenuItem *item,
                                           NMAccessPoint *ap);
 
+gboolean   nm_network_menu_item_remove_dupe (NMNetworkMenuItem *item,
+                                             NMAccessPoint *ap);
+
+gboolean   nm_network_menu_item_is_empty (NMNetworkMenuItem *item);
+
 void       nm_network_menu_item_set_active (NMNetworkMenuItem * item,
                                             gboolean active);
 
@@ -18,6 +18,9 @@
 #define KEYRING_SN_TAG "setting-name"
 #define KEYRING_SK_TAG "setting-key"
 
+/* How long secrets read from the keyring are kept around */
+#define KEYRING_CACHE_TIMEOUT_SEC 300
+
 static const SecretSchema network_manager_secret_schema = {
 	"org.freedesktop.NetworkManager.Connection",
 	SECRET_SCHEMA_DONT_MATCH_NAME,
@@ -37,6 +40,15 @@ typedef struct {
 	GHashTable *requests;
 	gboolean vpn_only;
 
+	/* "<uuid>/<setting name>" -> KeyringCacheEntry; the generation is bumped
+	 * whenever the cache is invalidated, so that keyring searches which
+	 * were already running don't fill it with stale secrets.
+	 */
+	GHashTable *keyring_cache;
+	guint keyring_generation;
+	SecretService *secret_service;
+	gboolean keyring_watched;
+
 	gboolean disposed;
 } AppletAgentPrivate;
 
@@ -66,6 +78,7 @@ typedef struct {
 
 	GCancellable *cancellable;
 	gint keyring_calls;
+	guint keyring_generation;
 } Request;
 
 static Request *
@@ -120,6 +133,258 @@ request_free (Request *r)
 
 /*******************************************************/
 
+typedef struct {
+	char *key;
+	SecretValue *value;
+} KeyringSecret;
+
+static void
+keyring_secret_free (gpointer data)
+{
+	KeyringSecret *secret = data;
+
+	g_free (secret->key);
+	secret_value_unref (secret->value);
+	g_slice_free (KeyringSecret, secret);
+}
+
+static GPtrArray *
+keyring_secrets_from_items (GList *items)
+{
+	GPtrArray *secrets;
+	GList *iter;
+
+	secrets = g_ptr_array_new_with_free_func (keyring_secret_free);
+	for (iter = items; iter; iter = g_list_next (iter)) {
+		SecretItem *item = iter->data;
+		SecretValue *value;
+		GHashTable *attributes;
+		const char *key_name;
+		KeyringSecret *secret;
+
+		value = secret_item_get_secret (item);
+		if (!value)
+			continue;
+
+		attributes = secret_item_get_attributes (item);
+		key_name = g_hash_table_lookup (attributes, KEYRING_SK_TAG);
+		if (key_name) {
+			secret = g_slice_new (KeyringSecret);
+			secret->key = g_strdup (key_name);
+			secret->value = value;
+			g_ptr_array_add (secrets, secret);
+		} else
+			secret_value_unref (value);
+		g_hash_table_unref (attributes);
+	}
+
+	return secrets;
+}
+
+/* Secrets are cached as the SecretValues libsecret returned, which keep
+ * them in non-pageable memory.
+ */
+typedef struct {
+	AppletAgent *agent;
+	char *key;
+	GPtrArray *secrets;
+	guint timeout_id;
+} KeyringCacheEntry;
+
+static void
+keyring_cache_entry_free (gpointer data)
+{
+	KeyringCacheEntry *entry = data;
+
+	nm_clear_g_source (&entry->timeout_id);
+	g_ptr_array_unref (entry->secrets);
+	g_free (entry->key);
+	g_slice_free (KeyringCacheEntry, entry);
+}
+
+static gboolean
+keyring_cache_entry_expired (gpointer user_data)
+{
+	KeyringCacheEntry *entry = user_data;
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (entry->agent);
+
+	entry->timeout_id = 0;
+	g_hash_table_remove (priv->keyring_cache, entry->key);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+keyring_cache_clear (AppletAgent *self)
+{
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
+
+	priv->keyring_generation++;
+	g_hash_table_remove_all (priv->keyring_cache);
+}
+
+static void
+keyring_cache_invalidate (AppletAgent *self, const char *uuid)
+{
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
+	GHashTableIter iter;
+	KeyringCacheEntry *entry;
+	gsize len = strlen (uuid);
+
+	priv->keyring_generation++;
+
+	g_hash_table_iter_init (&iter, priv->keyring_cache);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &entry)) {
+		if (!strncmp (entry->key, uuid, len) && entry->key[len] == '/')
+			g_hash_table_iter_remove (&iter);
+	}
+}
+
+static void keyring_watch_collections (AppletAgent *self);
+static void keyring_watch_items (AppletAgent *self, SecretCollection *collection);
+
+static void
+keyring_changed_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	AppletAgent *self = user_data;
+
+	if (APPLET_AGENT_GET_PRIVATE (self)->disposed)
+		return;
+
+	/* Items were added, removed, changed, locked or unlocked behind our back */
+	keyring_cache_clear (self);
+	if (SECRET_IS_SERVICE (object))
+		keyring_watch_collections (self);
+	else if (SECRET_IS_COLLECTION (object))
+		keyring_watch_items (self, SECRET_COLLECTION (object));
+}
+
+/* libsecret only follows changes to the items a collection has loaded.
+ * Changing the secret or the attributes of an item bumps its
+ * modification time.
+ */
+static void
+keyring_watch_items (AppletAgent *self, SecretCollection *collection)
+{
+	GList *items, *iter;
+
+	items = secret_collection_get_items (collection);
+	for (iter = items; iter; iter = g_list_next (iter)) {
+		g_signal_handlers_disconnect_by_func (iter->data, keyring_changed_cb, self);
+		g_signal_connect_object (iter->data, "notify::modified",
+		                         G_CALLBACK (keyring_changed_cb), self, 0);
+		g_signal_connect_object (iter->data, "notify::attributes",
+		                         G_CALLBACK (keyring_changed_cb), self, 0);
+	}
+	g_list_free_full (items, g_object_unref);
+}
+
+static void
+keyring_items_loaded_cb (GObject *source,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	AppletAgent *self = user_data;
+	SecretCollection *collection = SECRET_COLLECTION (source);
+
+	if (   secret_collection_load_items_finish (collection, result, NULL)
+	    && !APPLET_AGENT_GET_PRIVATE (self)->disposed) {
+		/* Changes made while the items were loading went unnoticed */
+		keyring_cache_clear (self);
+		keyring_watch_items (self, collection);
+	}
+
+	g_object_unref (self);
+}
+
+static void
+keyring_watch_collections (AppletAgent *self)
+{
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
+	GList *collections, *iter;
+
+	collections = secret_service_get_collections (priv->secret_service);
+	for (iter = collections; iter; iter = g_list_next (iter)) {
+		SecretCollection *collection = iter->data;
+
+		g_signal_handlers_disconnect_by_func (collection, keyring_changed_cb, self);
+		g_signal_connect_object (collection, "notify::items",
+		                         G_CALLBACK (keyring_changed_cb), self, 0);
+		g_signal_connect_object (collection, "notify::locked",
+		                         G_CALLBACK (keyring_changed_cb), self, 0);
+
+		if (secret_collection_get_flags (collection) & SECRET_COLLECTION_LOAD_ITEMS)
+			keyring_watch_items (self, collection);
+		else {
+			secret_collection_load_items (collection, NULL,
+			                              keyring_items_loaded_cb,
+			                              g_object_ref (self));
+		}
+	}
+	g_list_free_full (collections, g_object_unref);
+}
+
+static void
+keyring_service_ready_cb (GObject *source,
+                          GAsyncResult *result,
+                          gpointer user_data)
+{
+	AppletAgent *self = user_data;
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
+	SecretService *service;
+
+	service = secret_service_get_finish (result, NULL);
+	if (service && !priv->disposed) {
+		priv->secret_service = service;
+		g_signal_connect_object (service, "notify::collections",
+		                         G_CALLBACK (keyring_changed_cb), self, 0);
+		keyring_watch_collections (self);
+	} else
+		g_clear_object (&service);
+
+	g_object_unref (self);
+}
+
+static GPtrArray *
+keyring_cache_lookup (AppletAgent *self, const char *uuid, const char *setting_name)
+{
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
+	gs_free char *key = g_strdup_printf ("%s/%s", uuid, setting_name);
+	KeyringCacheEntry *entry;
+
+	entry = g_hash_table_lookup (priv->keyring_cache, key);
+	return entry ? g_ptr_array_ref (entry->secrets) : NULL;
+}
+
+static void
+keyring_cache_add (Request *r, GPtrArray *secrets)
+{
+	AppletAgent *self = APPLET_AGENT (r->agent);
+	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
+	KeyringCacheEntry *entry;
+
+	/* Don't cache what may have changed while the search was running */
+	if (r->keyring_generation != priv->keyring_generation)
+		return;
+
+	entry = g_slice_new0 (KeyringCacheEntry);
+	entry->agent = self;
+	entry->key = g_strdup_printf ("%s/%s", nm_connection_get_uuid (r->connection), r->setting_name);
+	entry->secrets = g_ptr_array_ref (secrets);
+	entry->timeout_id = g_timeout_add_seconds (KEYRING_CACHE_TIMEOUT_SEC,
+	                                           keyring_cache_entry_expired,
+	                                           entry);
+	g_hash_table_insert (priv->keyring_cache, entry->key, entry);
+
+	/* Start listening for changes made by others once there's something to lose */
+	if (!priv->keyring_watched) {
+		priv->keyring_watched = TRUE;
+		secret_service_get (SECRET_SERVICE_LOAD_COLLECTIONS, NULL,
+		                    keyring_service_ready_cb, g_object_ref (self));
+	}
+}
+
+/*******************************************************/
+
 static void
 get_save_cb (NMSecretAgentOld *agent,
              NMConnection *connection,
@@ -255,57 +520,26 @@ is_connection_always_ask (NMConnection *connection)
 }
 
 static void
-keyring_find_secrets_cb (GObject *source,
-                         GAsyncResult *result,
-                         gpointer user_data)
+keyring_secrets_found (Request *r, GPtrArray *secrets, GError *error)
 {
-	Request *r = user_data;
-	GError *error = NULL;
-	GError *search_error = NULL;
 	const char *connection_id = NULL;
 	GVariantBuilder builder_setting, builder_connection;
 	GVariantBuilder *wg_peers_builder = NULL;
 	GVariant *settings = NULL;
-	GList *list = NULL;
-	GList *iter;
 	gboolean hint_found = FALSE, ask = FALSE;
+	guint i;
 
-	r->keyring_calls--;
-	if (g_cancellable_is_cancelled (r->cancellable)) {
-		/* Callback already called by NM or dispose */
-		request_free (r);
-		return;
-	}
+	if (error)
+		goto done;
 
-	list = secret_service_search_finish (NULL, result, &search_error);
 	connection_id = nm_connection_get_id (r->connection);
 
-	if (g_error_matches (search_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-		error = g_error_new_literal (NM_SECRET_AGENT_ERROR,
-		                             NM_SECRET_AGENT_ERROR_USER_CANCELED,
-		                             "The secrets request was canceled by the user");
-		g_error_free (search_error);
-		goto done;
-	} else if (   (r->flags & NM_SECRET_AGENT_GET_SECRETS_FLAG_ALLOW_INTERACTION)
-	           && g_error_matches (search_error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN)) {
-		/* If the connection always asks for secrets, tolerate
-		 * keyring service not being present. */
-		g_clear_error (&search_error);
-	} else if (search_error) {
-		error = g_error_new (NM_SECRET_AGENT_ERROR,
-		                     NM_SECRET_AGENT_ERROR_FAILED,
-		                     "%s.%d - failed to read secrets from keyring (%s)",
-		                     __FILE__, __LINE__, search_error->message);
-		g_error_free (search_error);
-		goto done;
-	}
-
 	/* Only ask if we're allowed to, so that eg a connection editor which
 	 * requests secrets for its UI, for a connection which doesn't have any
 	 * secrets yet, doesn't trigger the applet secrets dialog.
 	 */
 	if (   (r->flags & NM_SECRET_AGENT_GET_SECRETS_FLAG_ALLOW_INTERACTION)
-	    && g_list_length (list) == 0) {
+	    && secrets->len == 0) {
 		g_message ("No keyring secrets found for %s/%s; asking user.", connection_id, r->setting_name);
 		ask_for_secrets (r);
 		return;
@@ -313,60 +547,44 @@ keyring_find_secrets_cb (GObject *source,
 
 	g_variant_builder_init (&builder_setting, NM_VARIANT_TYPE_SETTING);
 
-	/* Extract the secrets from the list of matching keyring items */
-	for (iter = list; iter != NULL; iter = g_list_next (iter)) {
-		SecretItem *item = iter->data;
-		SecretValue *secret;
-		const char *key_name;
-		GHashTable *attributes;
-
-		secret = secret_item_get_secret (item);
-		if (secret) {
-			attributes = secret_item_get_attributes (item);
-			key_name = g_hash_table_lookup (attributes, KEYRING_SK_TAG);
-			if (!key_name) {
-				g_hash_table_unref (attributes);
-				secret_value_unref (secret);
-				continue;
-			}
-
-			if (   nm_streq0 (r->setting_name, NM_SETTING_WIREGUARD_SETTING_NAME)
-			    && g_str_has_prefix (key_name, NM_SETTING_WIREGUARD_PEERS ".")
-			    && g_str_has_suffix (&key_name[NM_STRLEN(NM_SETTING_WIREGUARD_PEERS ".")],
-			                         "." NM_WIREGUARD_PEER_ATTR_PRESHARED_KEY)) {
-				GVariantBuilder peer_builder;
-				char *public_key = NULL;
-
-				if (!wg_peers_builder)
-					wg_peers_builder = g_variant_builder_new (G_VARIANT_TYPE ("aa{sv}"));
-
-				public_key = g_strndup (key_name + NM_STRLEN (NM_SETTING_WIREGUARD_PEERS "."),
-				                        strlen (key_name)
-				                        - NM_STRLEN (NM_SETTING_WIREGUARD_PEERS ".")
-				                        - NM_STRLEN ("." NM_WIREGUARD_PEER_ATTR_PRESHARED_KEY));
-
-				g_variant_builder_init (&peer_builder, G_VARIANT_TYPE ("a{sv}"));
-				g_variant_builder_add (&peer_builder, "{sv}",
-				                       NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY,
-				                       g_variant_new_take_string (public_key));
-				g_variant_builder_add (&peer_builder, "{sv}",
-				                       NM_WIREGUARD_PEER_ATTR_PRESHARED_KEY,
-				                       g_variant_new_string (secret_value_get (secret, NULL)));
-				g_variant_builder_add_value (wg_peers_builder, g_variant_builder_end (&peer_builder));
-
-			} else {
-				g_variant_builder_add (&builder_setting, "{sv}", key_name,
-				                       g_variant_new_string (secret_value_get (secret, NULL)));
-			}
-
-			/* See if this property matches a given hint */
-			if (r->hints && r->hints[0]) {
-				if (!g_strcmp0 (r->hints[0], key_name) || !g_strcmp0 (r->hints[1], key_name))
-					hint_found = TRUE;
-			}
+	/* Extract the secrets from the matching keyring items */
+	for (i = 0; i < secrets->len; i++) {
+		KeyringSecret *secret = secrets->pdata[i];
+		const char *key_name = secret->key;
+
+		if (   nm_streq0 (r->setting_name, NM_SETTING_WIREGUARD_SETTING_NAME)
+		    && g_str_has_prefix (key_name, NM_SETTING_WIREGUARD_PEERS ".")
+		    && g_str_has_suffix (&key_name[NM_STRLEN(NM_SETTING_WIREGUARD_PEERS ".")],
+		                         "." NM_WIREGUARD_PEER_ATTR_PRESHARED_KEY)) {
+			GVariantBuilder peer_builder;
+			char *public_key = NULL;
+
+			if (!wg_peers_builder)
+				wg_peers_builder = g_variant_builder_new (G_VARIANT_TYPE ("aa{sv}"));
+
+			public_key = g_strndup (key_name + NM_STRLEN (NM_SETTING_WIREGUARD_PEERS "."),
+			                        strlen (key_name)
+			                        - NM_STRLEN (NM_SETTING_WIREGUARD_PEERS ".")
+			                        - NM_STRLEN ("." NM_WIREGUARD_PEER_ATTR_PRESHARED_KEY));
+
+			g_variant_builder_init (&peer_builder, G_VARIANT_TYPE ("a{sv}"));
+			g_variant_builder_add (&peer_builder, "{sv}",
+			                       NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY,
+			                       g_variant_new_take_string (public_key));
+			g_variant_builder_add (&peer_builder, "{sv}",
+			                       NM_WIREGUARD_PEER_ATTR_PRESHARED_KEY,
+			                       g_variant_new_string (secret_value_get (secret->value, NULL)));
+			g_variant_builder_add_value (wg_peers_builder, g_variant_builder_end (&peer_builder));
+
+		} else {
+			g_variant_builder_add (&builder_setting, "{sv}", key_name,
+			                       g_variant_new_string (secret_value_get (secret->value, NULL)));
+		}
 
-			g_hash_table_unref (attributes);
-			secret_value_unref (secret);
+		/* See if this property matches a given hint */
+		if (r->hints && r->hints[0]) {
+			if (!g_strcmp0 (r->hints[0], key_name) || !g_strcmp0 (r->hints[1], key_name))
+				hint_found = TRUE;
 		}
 	}
 
@@ -399,7 +617,6 @@ keyring_find_secrets_cb (GObject *source,
 	settings = g_variant_ref_sink (g_variant_builder_end (&builder_connection));
 
 done:
-	g_list_free_full (list, g_object_unref);
 	if (ask) {
 		GVariantIter dict_iter;
 		const char *setting_name;
@@ -424,6 +641,56 @@ done:
 
 	if (settings)
 		g_variant_unref (settings);
+}
+
+static void
+keyring_find_secrets_cb (GObject *source,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	Request *r = user_data;
+	GError *error = NULL;
+	GError *search_error = NULL;
+	GPtrArray *secrets = NULL;
+	GList *list = NULL;
+
+	r->keyring_calls--;
+	if (g_cancellable_is_cancelled (r->cancellable)) {
+		/* Callback already called by NM or dispose */
+		request_free (r);
+		return;
+	}
+
+	list = secret_service_search_finish (NULL, result, &search_error);
+
+	if (g_error_matches (search_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		error = g_error_new_literal (NM_SECRET_AGENT_ERROR,
+		                             NM_SECRET_AGENT_ERROR_USER_CANCELED,
+		                             "The secrets request was canceled by the user");
+		g_error_free (search_error);
+	} else if (   (r->flags & NM_SECRET_AGENT_GET_SECRETS_FLAG_ALLOW_INTERACTION)
+	           && g_error_matches (search_error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN)) {
+		/* If the connection always asks for secrets, tolerate
+		 * keyring service not being present. */
+		g_clear_error (&search_error);
+		secrets = keyring_secrets_from_items (NULL);
+	} else if (search_error) {
+		error = g_error_new (NM_SECRET_AGENT_ERROR,
+		                     NM_SECRET_AGENT_ERROR_FAILED,
+		                     "%s.%d - failed to read secrets from keyring (%s)",
+		                     __FILE__, __LINE__, search_error->message);
+		g_error_free (search_error);
+	} else {
+		secrets = keyring_secrets_from_items (list);
+		if (secrets->len)
+			keyring_cache_add (r, secrets);
+	}
+	g_list_free_full (list, g_object_unref);
+
+	keyring_secrets_found (r, secrets, error);
+
+	if (secrets)
+		g_ptr_array_unref (secrets);
 	g_clear_error (&error);
 }
 
@@ -444,6 +711,7 @@ get_secrets (NMSecretAgentOld *agent,
 	NMSetting *setting;
 	const char *uuid, *ctype;
 	GHashTable *attrs;
+	GPtrArray *secrets;
 
 	setting = nm_connection_get_setting_by_name (connection, setting_name);
 	if (!setting) {
@@ -493,8 +761,17 @@ get_secrets (NMSecretAgentOld *agent,
 	}
 
 	/* For everything else we scrape the keyring for secrets first, and ask
-	 * later if required.
+	 * later if required.  Repeated requests for the same setting, e.g. when
+	 * reauthenticating, are answered from the cache.
 	 */
+	secrets = keyring_cache_lookup (APPLET_AGENT (agent), uuid, setting_name);
+	if (secrets) {
+		keyring_secrets_found (r, secrets, NULL);
+		g_ptr_array_unref (secrets);
+		return;
+	}
+
+	r->keyring_generation = priv->keyring_generation;
 	attrs = secret_attributes_build (&network_manager_secret_schema,
 	                                 KEYRING_UUID_TAG, uuid,
 	                                 KEYRING_SN_TAG, setting_name,
@@ -554,8 +831,11 @@ save_request_try_complete (Request *r)
 	 * secrets have been saved to the keyring.
 	 */
 	if (r->keyring_calls == 0) {
-		if (!g_cancellable_is_cancelled (r->cancellable))
+		if (!g_cancellable_is_cancelled (r->cancellable)) {
+			/* Drop whatever was read while the secrets were being replaced */
+			keyring_cache_invalidate (APPLET_AGENT (r->agent), nm_connection_get_uuid (r->connection));
 			r->save_callback (NM_SECRET_AGENT_OLD (r->agent), r->connection, NULL, r->callback_data);
+		}
 		request_free (r);
 	}
 }
@@ -745,6 +1025,8 @@ save_secrets (NMSecretAgentOld *agent,
 	r = request_new (agent, connection, connection_path, NULL, NULL, FALSE, NULL, callback, NULL, callback_data);
 	g_hash_table_insert (priv->requests, GUINT_TO_POINTER (r->id), r);
 
+	keyring_cache_invalidate (APPLET_AGENT (agent), nm_connection_get_uuid (connection));
+
 	/* First delete any existing items in the keyring */
 	nm_secret_agent_old_delete_secrets (agent, connection, save_delete_cb, r);
 }
@@ -800,6 +1082,8 @@ delete_secrets (NMSecretAgentOld *agent,
 	uuid = nm_setting_connection_get_uuid (s_con);
 	g_assert (uuid);
 
+	keyring_cache_invalidate (APPLET_AGENT (agent), uuid);
+
 	secret_password_clear (&network_manager_secret_schema, r->cancellable,
 	                       delete_find_items_cb, r,
 	                       KEYRING_UUID_TAG, uuid,
@@ -841,6 +1125,8 @@ applet_agent_init (AppletAgent *self)
 	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (self);
 
 	priv->requests = g_hash_table_new (g_direct_hash, g_direct_equal);
+	priv->keyring_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                             NULL, keyring_cache_entry_free);
 }
 
 static void
@@ -859,6 +1145,8 @@ dispose (GObject *object)
 			g_cancellable_cancel (r->cancellable);
 
 		g_hash_table_destroy (priv->requests);
+		g_hash_table_destroy (priv->keyring_cache);
+		g_clear_object (&priv->secret_service);
 		priv->disposed = TRUE;
 	}
 
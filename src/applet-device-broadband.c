@@ -33,7 +33,13 @@ typedef struct {
 	guint operator_name_update_id;
 	guint operator_code_update_id;
 	guint sid_update_id;
-	NMAMobileProvidersDatabase *mpd;
+	guint registration_state_update_id;
+
+	/* Last signal state propagated to the icon and menu */
+	guint quality_bucket;
+	guint32 mb_tech;
+	guint32 mb_state;
+	GtkWidget *menu_item;
 
 	/* Unlock dialog stuff */
 	GtkWidget *dialog;
@@ -698,6 +704,19 @@ add_connection_item (NMDevice *device,
 	gtk_widget_show (item);
 }
 
+/* Remember the NMMbMenuItem showing the modem state, if the current menu has
+ * one, so that signal updates can be applied to it in place.
+ */
+static void
+set_menu_item (BroadbandDeviceInfo *info, GtkWidget *item)
+{
+	if (info->menu_item)
+		g_object_remove_weak_pointer (G_OBJECT (info->menu_item), (gpointer *) &info->menu_item);
+	info->menu_item = item;
+	if (info->menu_item)
+		g_object_add_weak_pointer (G_OBJECT (info->menu_item), (gpointer *) &info->menu_item);
+}
+
 static gboolean
 add_menu_item (NMDevice *device,
                gboolean multiple_devices,
@@ -727,6 +746,8 @@ add_menu_item (NMDevice *device,
 		text = g_strdup (_("Mobile Broadband"));
 	}
 
+	set_menu_item (info, NULL);
+
 	item = applet_menu_item_create_device_item_helper (device, applet, text);
 	gtk_widget_set_sensitive (item, FALSE);
 	gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
@@ -749,6 +770,7 @@ add_menu_item (NMDevice *device,
 		                            mm_modem_get_state (info->mm_modem) >= MM_MODEM_STATE_ENABLED,
 		                            applet);
 		gtk_widget_set_sensitive (GTK_WIDGET (item), TRUE);
+		set_menu_item (info, item);
 		add_connection_item (device, active, item, menu, applet);
 	}
 
@@ -770,6 +792,7 @@ add_menu_item (NMDevice *device,
 		                            mm_modem_get_state (info->mm_modem) >= MM_MODEM_STATE_ENABLED,
 		                            applet);
 		gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
+		set_menu_item (info, item);
 		gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
 		gtk_widget_show (item);
 	}
@@ -814,13 +837,46 @@ notify_connected (NMDevice *device,
 
 /********************************************************************/
 
+/* Some modems report signal quality every second or so; only bother the
+ * icon and menu when the quality bucket, the access technology or the
+ * home/roaming state actually change.
+ */
+static void
+signal_state_updated (BroadbandDeviceInfo *info, gboolean force)
+{
+	guint32 quality;
+	guint bucket;
+	guint32 mb_tech;
+	guint32 mb_state;
+
+	quality = mm_modem_get_signal_quality (info->mm_modem, NULL);
+	bucket = mobile_helper_get_quality_bucket (quality);
+	mb_tech = broadband_act_to_mb_act (info);
+	mb_state = broadband_state_to_mb_state (info);
+
+	if (   !force
+	    && bucket == info->quality_bucket
+	    && mb_tech == info->mb_tech
+	    && mb_state == info->mb_state)
+		return;
+
+	info->quality_bucket = bucket;
+	info->mb_tech = mb_tech;
+	info->mb_state = mb_state;
+
+	applet_schedule_update_icon (info->applet);
+
+	/* Update the open menu in place rather than rebuilding it */
+	if (info->menu_item)
+		nm_mb_menu_item_update (NM_MB_MENU_ITEM (info->menu_item), quality, mb_tech, mb_state);
+}
+
 static void
 signal_quality_updated (GObject *object,
                         GParamSpec *pspec,
                         BroadbandDeviceInfo *info)
 {
-	applet_schedule_update_icon (info->applet);
-	applet_schedule_update_menu (info->applet);
+	signal_state_updated (info, FALSE);
 }
 
 static void
@@ -828,8 +884,15 @@ access_technologies_updated (GObject *object,
                              GParamSpec *pspec,
                              BroadbandDeviceInfo *info)
 {
-	applet_schedule_update_icon (info->applet);
-	applet_schedule_update_menu (info->applet);
+	signal_state_updated (info, FALSE);
+}
+
+static void
+registration_state_updated (GObject *object,
+                            GParamSpec *pspec,
+                            BroadbandDeviceInfo *info)
+{
+	signal_state_updated (info, FALSE);
 }
 
 static void
@@ -844,7 +907,6 @@ operator_info_updated (GObject *object,
 
 	if (info->mm_modem_3gpp) {
 		info->operator_name = (mobile_helper_parse_3gpp_operator_name (
-			                       &(info->mpd),
 			                       mm_modem_3gpp_get_operator_name (info->mm_modem_3gpp),
 			                       mm_modem_3gpp_get_operator_code (info->mm_modem_3gpp)));
 		if (info->operator_name)
@@ -853,10 +915,22 @@ operator_info_updated (GObject *object,
 
 	if (info->mm_modem_cdma)
 		info->operator_name = (mobile_helper_parse_3gpp2_operator_name (
-			                       &(info->mpd),
 			                       mm_modem_cdma_get_sid (info->mm_modem_cdma)));
 }
 
+static void
+providers_loaded (gpointer user_data)
+{
+	BroadbandDeviceInfo *info = user_data;
+
+	/* Resolve operator names that were left as MCC/MNC or SID */
+	if (info->mm_modem_3gpp || info->mm_modem_cdma) {
+		operator_info_updated (NULL, NULL, info);
+		applet_schedule_update_icon (info->applet);
+		applet_schedule_update_menu (info->applet);
+	}
+}
+
 static void
 setup_signals (BroadbandDeviceInfo *info,
                gboolean enable)
@@ -867,6 +941,7 @@ setup_signals (BroadbandDeviceInfo *info,
 		g_assert (info->operator_name_update_id == 0);
 		g_assert (info->operator_code_update_id == 0);
 		g_assert (info->sid_update_id == 0);
+		g_assert (info->registration_state_update_id == 0);
 
 		info->mm_modem_3gpp = mm_object_get_modem_3gpp (info->mm_object);
 		info->mm_modem_cdma = mm_object_get_modem_cdma (info->mm_object);
@@ -880,6 +955,10 @@ setup_signals (BroadbandDeviceInfo *info,
 			                                                  "notify::operator-code",
 			                                                  G_CALLBACK (operator_info_updated),
 			                                                  info);
+			info->registration_state_update_id = g_signal_connect (info->mm_modem_3gpp,
+			                                                       "notify::registration-state",
+			                                                       G_CALLBACK (registration_state_updated),
+			                                                       info);
 		}
 
 		if (info->mm_modem_cdma) {
@@ -903,6 +982,11 @@ setup_signals (BroadbandDeviceInfo *info,
 					g_signal_handler_disconnect (info->mm_modem_3gpp, info->operator_code_update_id);
 				info->operator_code_update_id = 0;
 			}
+			if (info->registration_state_update_id) {
+				if (g_signal_handler_is_connected (info->mm_modem_3gpp, info->registration_state_update_id))
+					g_signal_handler_disconnect (info->mm_modem_3gpp, info->registration_state_update_id);
+				info->registration_state_update_id = 0;
+			}
 			g_clear_object (&info->mm_modem_3gpp);
 		}
 
@@ -959,6 +1043,8 @@ modem_state_changed (MMModem *object,
 			                            PREF_DISABLE_CONNECTED_NOTIFICATIONS);
 		}
 	}
+
+	signal_state_updated (info, FALSE);
 }
 
 /********************************************************************/
@@ -968,9 +1054,9 @@ broadband_device_info_free (BroadbandDeviceInfo *info)
 {
 	setup_signals (info, FALSE);
 
+	mobile_helper_providers_unwatch (info);
+	set_menu_item (info, NULL);
 	g_free (info->operator_name);
-	if (info->mpd)
-		g_object_unref (info->mpd);
 
 	if (info->mm_sim)
 		g_object_unref (info->mm_sim);
@@ -1041,10 +1127,10 @@ device_added (NMDevice *device,
 	                  info);
 
 	/* Load initial values */
-	signal_quality_updated (NULL, NULL, info);
-	access_technologies_updated (NULL, NULL, info);
 	if (mm_modem_get_state (info->mm_modem) >= MM_MODEM_STATE_ENABLED)
 		setup_signals (info, TRUE);
+	signal_state_updated (info, TRUE);
+	mobile_helper_providers_watch (providers_loaded, info);
 
 	/* Asynchronously get SIM */
 	mm_modem_get_sim (info->mm_modem,
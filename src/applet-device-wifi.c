@@ -562,40 +562,111 @@ wifi_menu_item_activate (GtkMenuItem *item, gpointer user_data)
 	                                  user_data);
 }
 
-struct dup_data {
-	NMDevice *device;
-	NMNetworkMenuItem *found;
-	char *hash;
-};
+/* The network items of a device's menu are kept indexed by their key for
+ * as long as the menu exists, so that access points appearing and going
+ * away can be applied to the existing items instead of rebuilding the
+ * whole menu for every scan result.
+ */
+#define WIFI_MENU_TAG "wifi-menu"
+
+typedef struct {
+	NMApplet *applet;
+	NMDeviceWifi *device;
+	gboolean multiple_devices;
+	GtkWidget *header;
+	GtkWidget *subitem;
+	GtkWidget *submenu;
+	NMNetworkMenuItem *active_item;
+	GHashTable *items;
+} WifiMenu;
+
+static void wifi_menu_submenu_destroyed (GtkWidget *submenu, gpointer user_data);
 
 static void
-find_duplicate (gpointer d, gpointer user_data)
+wifi_menu_free (gpointer data)
 {
-	struct dup_data * data = (struct dup_data *) user_data;
-	NMDevice *device;
-	const char *hash;
-	GtkWidget *widget = GTK_WIDGET (d);
+	WifiMenu *wmenu = data;
 
-	g_assert (d && widget);
-	g_return_if_fail (data);
-	g_return_if_fail (data->hash);
+	g_signal_handlers_disconnect_by_func (wmenu->submenu, wifi_menu_submenu_destroyed, wmenu);
+	g_object_unref (wmenu->header);
+	g_hash_table_destroy (wmenu->items);
+	g_slice_free (WifiMenu, wmenu);
+}
 
-	if (data->found || !NM_IS_NETWORK_MENU_ITEM (widget))
-		return;
+static void
+wifi_menu_submenu_destroyed (GtkWidget *submenu, gpointer user_data)
+{
+	WifiMenu *wmenu = user_data;
 
-	device = g_object_get_data (G_OBJECT (widget), "device");
-	if (NM_DEVICE (device) != data->device)
-		return;
+	g_object_set_data (G_OBJECT (wmenu->device), WIFI_MENU_TAG, NULL);
+}
+
+static char *
+wifi_menu_header_text (NMDeviceWifi *device, gboolean multiple_devices)
+{
+	const GPtrArray *aps;
+	const char *desc;
 
-	hash = nm_network_menu_item_get_hash (NM_NETWORK_MENU_ITEM (widget));
-	if (hash && (strcmp (hash, data->hash) == 0))
-		data->found = NM_NETWORK_MENU_ITEM (widget);
+	aps = nm_device_wifi_get_access_points (device);
+
+	if (multiple_devices) {
+		desc = nm_device_get_description (NM_DEVICE (device));
+		if (aps && aps->len > 1)
+			return g_strdup_printf (_("Wi-Fi Networks (%s)"), desc);
+		else
+			return g_strdup_printf (_("Wi-Fi Network (%s)"), desc);
+	} else
+		return g_strdup (ngettext ("Wi-Fi Network", "Wi-Fi Networks", aps ? aps->len : 0));
+}
+
+/* The header counts all access points, listed or not */
+static void
+wifi_menu_update_header (WifiMenu *wmenu)
+{
+	char *text;
+
+	text = wifi_menu_header_text (wmenu->device, wmenu->multiple_devices);
+	gtk_menu_item_set_label (GTK_MENU_ITEM (wmenu->header), text);
+	g_free (text);
+}
+
+static WifiMenu *
+wifi_menu_new (NMDeviceWifi *device,
+               gboolean multiple_devices,
+               GtkWidget *header,
+               GtkWidget *subitem,
+               GtkWidget *submenu,
+               NMNetworkMenuItem *active_item,
+               NMApplet *applet)
+{
+	WifiMenu *wmenu;
+
+	wmenu = g_slice_new0 (WifiMenu);
+	wmenu->applet = applet;
+	wmenu->device = device;
+	wmenu->multiple_devices = multiple_devices;
+	wmenu->header = g_object_ref (header);
+	wmenu->subitem = subitem;
+	wmenu->submenu = submenu;
+	wmenu->active_item = active_item;
+	wmenu->items = utils_ap_groups_new (g_object_unref);
+	if (active_item) {
+		utils_ap_groups_insert (wmenu->items,
+		                        nm_network_menu_item_get_key (active_item),
+		                        g_object_ref (active_item));
+	}
+
+	g_signal_connect (submenu, "destroy",
+	                  G_CALLBACK (wifi_menu_submenu_destroyed), wmenu);
+	g_object_set_data_full (G_OBJECT (device), WIFI_MENU_TAG,
+	                        wmenu, wifi_menu_free);
+	return wmenu;
 }
 
 static NMNetworkMenuItem *
 create_new_ap_item (NMDeviceWifi *device,
                     NMAccessPoint *ap,
-                    struct dup_data *dup_data,
+                    const UtilsApKey *key,
                     const GPtrArray *connections,
                     NMApplet *applet)
 {
@@ -611,10 +682,11 @@ create_new_ap_item (NMDeviceWifi *device,
 
 	item = nm_network_menu_item_new (ap,
 	                                 nm_device_wifi_get_capabilities (device),
-	                                 dup_data->hash,
+	                                 key,
 	                                 ap_connections->len != 0,
 	                                 applet);
 	g_object_set_data (G_OBJECT (item), "device", NM_DEVICE (device));
+	g_object_set_data (G_OBJECT (item), "ap", ap);
 
 	/* If there's only one connection, don't show the submenu */
 	if (ap_connections->len > 1) {
@@ -671,42 +743,80 @@ create_new_ap_item (NMDeviceWifi *device,
 	return NM_NETWORK_MENU_ITEM (item);
 }
 
-static NMNetworkMenuItem *
-get_menu_item_for_ap (NMDeviceWifi *device,
-                      NMAccessPoint *ap,
-                      const GPtrArray *connections,
-                      GSList *menu_list,
-                      NMApplet *applet)
+static void
+ap_get_key (NMAccessPoint *ap, UtilsApKey *key)
+{
+	utils_ap_key_init (key,
+	                   nm_access_point_get_ssid (ap),
+	                   nm_access_point_get_mode (ap),
+	                   nm_access_point_get_flags (ap),
+	                   nm_access_point_get_wpa_flags (ap),
+	                   nm_access_point_get_rsn_flags (ap));
+}
+
+static gboolean
+ap_is_listed (NMAccessPoint *ap)
 {
 	GBytes *ssid;
-	struct dup_data dup_data = { NULL, NULL };
 
 	/* Don't add BSSs that hide their SSID or are blacklisted */
 	ssid = nm_access_point_get_ssid (ap);
 	if (   !ssid
 	    || nm_utils_is_empty_ssid (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid))
 	    || is_blacklisted_ssid (ssid))
+		return FALSE;
+	return TRUE;
+}
+
+typedef struct {
+	NMDeviceWifi *device;
+	const GPtrArray *connections;
+	NMApplet *applet;
+} ApGroupInfo;
+
+static gpointer
+ap_group_new (gpointer ap, const UtilsApKey *key, gpointer user_data)
+{
+	ApGroupInfo *info = user_data;
+	NMNetworkMenuItem *item;
+
+	item = create_new_ap_item (info->device, ap, key, info->connections, info->applet);
+	return g_object_ref (item);
+}
+
+static void
+ap_group_add (gpointer group, gpointer ap, gpointer user_data)
+{
+	ApGroupInfo *info = user_data;
+	NMNetworkMenuItem *item = group;
+
+	nm_network_menu_item_set_strength (item, nm_access_point_get_strength (ap), info->applet);
+	nm_network_menu_item_add_dupe (item, ap);
+}
+
+static NMNetworkMenuItem *
+get_menu_item_for_ap (NMDeviceWifi *device,
+                      NMAccessPoint *ap,
+                      const GPtrArray *connections,
+                      WifiMenu *wmenu,
+                      NMApplet *applet)
+{
+	ApGroupInfo info = { device, connections, applet };
+	UtilsApKey key;
+
+	if (!ap_is_listed (ap))
 		return NULL;
 
+	ap_get_key (ap, &key);
+	if (!wmenu)
+		return create_new_ap_item (device, ap, &key, connections, applet);
+
 	/* Find out if this AP is a member of a larger network that all uses the
 	 * same SSID and security settings.  If so, we'll already have a menu item
 	 * for this SSID, so just update that item's strength and add this AP to
 	 * menu item's duplicate list.
 	 */
-	dup_data.found = NULL;
-	dup_data.hash = g_object_get_data (G_OBJECT (ap), "hash");
-	g_return_val_if_fail (dup_data.hash != NULL, NULL);
-
-	dup_data.device = NM_DEVICE (device);
-	g_slist_foreach (menu_list, find_duplicate, &dup_data);
-
-	if (dup_data.found) {
-		nm_network_menu_item_set_strength (dup_data.found, nm_access_point_get_strength (ap), applet);
-		nm_network_menu_item_add_dupe (dup_data.found, ap);
-		return NULL;
-	}
-
-	return create_new_ap_item (device, ap, &dup_data, connections, applet);
+	return utils_ap_groups_add (wmenu->items, ap, &key, ap_group_new, ap_group_add, &info);
 }
 
 static gint
@@ -795,6 +905,84 @@ sort_toplevel (gconstpointer tmpa, gconstpointer tmpb)
 	return sort_by_name (a, b);
 }
 
+/* Returns FALSE if the change can't be applied in place and the menu
+ * needs to be rebuilt.
+ */
+static gboolean
+wifi_menu_add_ap (WifiMenu *wmenu, NMAccessPoint *ap)
+{
+	NMApplet *applet = wmenu->applet;
+	NMNetworkMenuItem *item;
+	GPtrArray *connections;
+	GList *children, *iter;
+	UtilsApKey key;
+	int pos;
+
+	if (!ap_is_listed (ap))
+		return TRUE;
+
+	/* The AP may already be part of the menu if it was rebuilt meanwhile */
+	ap_get_key (ap, &key);
+	item = g_hash_table_lookup (wmenu->items, &key);
+	if (item && nm_network_menu_item_find_dupe (item, ap))
+		return TRUE;
+
+	connections = applet_get_all_connections (applet);
+	item = get_menu_item_for_ap (wmenu->device, ap, connections, wmenu, applet);
+	g_ptr_array_unref (connections);
+	if (!item)
+		return TRUE;
+
+	/* Keep the order wifi_add_menu_item() would have produced */
+	pos = 0;
+	children = gtk_container_get_children (GTK_CONTAINER (wmenu->submenu));
+	for (iter = children; iter; iter = g_list_next (iter), pos++) {
+		if (sort_toplevel (item, iter->data) < 0)
+			break;
+	}
+	g_list_free (children);
+
+	gtk_menu_shell_insert (GTK_MENU_SHELL (wmenu->submenu), GTK_WIDGET (item), pos);
+	gtk_widget_show_all (GTK_WIDGET (item));
+	gtk_widget_set_sensitive (wmenu->subitem, TRUE);
+	return TRUE;
+}
+
+static gboolean
+wifi_menu_remove_ap (WifiMenu *wmenu, NMAccessPoint *ap)
+{
+	NMNetworkMenuItem *item;
+	UtilsApKey key;
+
+	/* An AP whose identity changed since it was added won't be found and
+	 * causes a rebuild.
+	 */
+	ap_get_key (ap, &key);
+	item = g_hash_table_lookup (wmenu->items, &key);
+	if (!item)
+		return ap_is_listed (ap) ? FALSE : TRUE;
+
+	if (!nm_network_menu_item_remove_dupe (item, ap))
+		return FALSE;
+
+	/* Activating the item would refer to the removed AP */
+	if (g_object_get_data (G_OBJECT (item), "ap") == ap)
+		return FALSE;
+
+	if (!nm_network_menu_item_is_empty (item))
+		return TRUE;
+
+	if (item == wmenu->active_item)
+		return FALSE;
+
+	gtk_widget_destroy (GTK_WIDGET (item));
+	g_hash_table_remove (wmenu->items, &key);
+
+	if (g_hash_table_size (wmenu->items) == (wmenu->active_item ? 1 : 0))
+		gtk_widget_set_sensitive (wmenu->subitem, FALSE);
+	return TRUE;
+}
+
 static gboolean
 wifi_add_menu_item (NMDevice *device,
                     gboolean multiple_devices,
@@ -815,39 +1003,34 @@ wifi_add_menu_item (NMDevice *device,
 	NMNetworkMenuItem *item, *active_item = NULL;
 	GtkWidget *widget;
 	GtkWidget *subitem;
+	GtkWidget *submenu;
+	GtkWidget *header;
+	WifiMenu *wmenu;
 
 	wdev = NM_DEVICE_WIFI (device);
 	aps = nm_device_wifi_get_access_points (wdev);
 
-	if (multiple_devices) {
-		const char *desc;
-
-		desc = nm_device_get_description (device);
-		if (aps && aps->len > 1)
-			text = g_strdup_printf (_("Wi-Fi Networks (%s)"), desc);
-		else
-			text = g_strdup_printf (_("Wi-Fi Network (%s)"), desc);
-	} else
-		text = g_strdup (ngettext ("Wi-Fi Network", "Wi-Fi Networks", aps ? aps->len : 0));
-
-	widget = applet_menu_item_create_device_item_helper (device, applet, text);
+	text = wifi_menu_header_text (wdev, multiple_devices);
+	header = applet_menu_item_create_device_item_helper (device, applet, text);
 	g_free (text);
 
-	gtk_widget_set_sensitive (widget, FALSE);
-	gtk_menu_shell_append (GTK_MENU_SHELL (menu), widget);
-	gtk_widget_show (widget);
+	gtk_widget_set_sensitive (header, FALSE);
+	gtk_menu_shell_append (GTK_MENU_SHELL (menu), header);
+	gtk_widget_show (header);
+
+	/* Forget the items of the previous menu */
+	g_object_set_data (G_OBJECT (device), WIFI_MENU_TAG, NULL);
 
 	/* Add the active AP if we're connected to something and the device is available */
 	if (!nma_menu_device_check_unusable (device)) {
 		active_ap = nm_device_wifi_get_active_access_point (wdev);
 		if (active_ap) {
-			active_item = item = get_menu_item_for_ap (wdev, active_ap, connections, NULL, applet);
-			if (item) {
-				nm_network_menu_item_set_active (item, TRUE);
-				menu_items = g_slist_append (menu_items, item);
+			active_item = get_menu_item_for_ap (wdev, active_ap, connections, NULL, applet);
+			if (active_item) {
+				nm_network_menu_item_set_active (active_item, TRUE);
 
-				gtk_menu_shell_append (GTK_MENU_SHELL (menu), GTK_WIDGET (item));
-				gtk_widget_show_all (GTK_WIDGET (item));
+				gtk_menu_shell_append (GTK_MENU_SHELL (menu), GTK_WIDGET (active_item));
+				gtk_widget_show_all (GTK_WIDGET (active_item));
 			}
 		}
 	}
@@ -868,40 +1051,36 @@ wifi_add_menu_item (NMDevice *device,
 	if (nma_menu_device_check_unusable (device))
 		goto out;
 
+	subitem = gtk_menu_item_new_with_mnemonic (_("_Available networks"));
+
+	/* The submenu is created even if empty so that networks showing up
+	 * later can be added to it.
+	 */
+	submenu = gtk_menu_new ();
+	gtk_menu_item_set_submenu (GTK_MENU_ITEM (subitem), submenu);
+
+	/* The active AP's item is indexed too, so that duplicates of the
+	 * active network are grouped into it.
+	 */
+	wmenu = wifi_menu_new (wdev, multiple_devices, header, subitem, submenu, active_item, applet);
+
 	/* Create menu items for the rest of the APs */
 	for (i = 0; aps && (i < aps->len); i++) {
 		NMAccessPoint *ap = g_ptr_array_index (aps, i);
 
-		item = get_menu_item_for_ap (wdev, ap, connections, menu_items, applet);
+		item = get_menu_item_for_ap (wdev, ap, connections, wmenu, applet);
 		if (item)
-			menu_items = g_slist_append (menu_items, item);
+			menu_items = g_slist_prepend (menu_items, item);
 	}
 
-	/* Now remove the active AP item from the list, as we've already dealt with
-	 * it.  (Needed it when creating menu items for the rest of the APs though
-	 * to ensure duplicate APs are handled correctly)
-	 */
-	if (active_item)
-		menu_items = g_slist_remove (menu_items, active_item);
-
-	subitem = gtk_menu_item_new_with_mnemonic (_("_Available networks"));
-
-	if (g_slist_length (menu_items)) {
-		GtkWidget *submenu;
-		GSList *sorted_subitems;
-
-		submenu = gtk_menu_new ();
-		gtk_menu_item_set_submenu (GTK_MENU_ITEM (subitem), submenu);
-
-		/* Sort the subitems alphabetically and by importance */
-		sorted_subitems = g_slist_copy (menu_items);
-		sorted_subitems = g_slist_sort (sorted_subitems, sort_by_name);
-		sorted_subitems = g_slist_sort (sorted_subitems, sort_toplevel);
+	if (menu_items) {
+		/* Sort the subitems by importance and alphabetically */
+		menu_items = g_slist_reverse (menu_items);
+		menu_items = g_slist_sort (menu_items, sort_toplevel);
 
 		/* Add menu items */
-		for (iter = sorted_subitems; iter; iter = g_slist_next (iter))
+		for (iter = menu_items; iter; iter = g_slist_next (iter))
 			gtk_menu_shell_append (GTK_MENU_SHELL (submenu), GTK_WIDGET (iter->data));
-		g_slist_free (sorted_subitems);
 	} else
 		gtk_widget_set_sensitive (subitem, FALSE);
 
@@ -950,36 +1129,6 @@ notify_active_ap_changed_cb (NMDeviceWifi *device,
 	applet_schedule_update_icon (applet);
 }
 
-static void
-add_hash_to_ap (NMAccessPoint *ap)
-{
-	char *hash;
-
-	hash = utils_hash_ap (nm_access_point_get_ssid (ap),
-	                      nm_access_point_get_mode (ap),
-	                      nm_access_point_get_flags (ap),
-	                      nm_access_point_get_wpa_flags (ap),
-	                      nm_access_point_get_rsn_flags (ap));
-	g_object_set_data_full (G_OBJECT (ap), "hash", hash, (GDestroyNotify) g_free);
-}
-
-static void
-notify_ap_prop_changed_cb (NMAccessPoint *ap,
-                           GParamSpec *pspec,
-                           NMApplet *applet)
-{
-	const char *prop = g_param_spec_get_name (pspec);
-
-	if (   !strcmp (prop, NM_ACCESS_POINT_FLAGS)
-	    || !strcmp (prop, NM_ACCESS_POINT_WPA_FLAGS)
-	    || !strcmp (prop, NM_ACCESS_POINT_RSN_FLAGS)
-	    || !strcmp (prop, NM_ACCESS_POINT_SSID)
-	    || !strcmp (prop, NM_ACCESS_POINT_FREQUENCY)
-	    || !strcmp (prop, NM_ACCESS_POINT_MODE)) {
-		add_hash_to_ap (ap);
-	}
-}
-
 static void
 wifi_available_dont_show_cb (NotifyNotification *notify,
 			                 gchar *id,
@@ -1112,15 +1261,18 @@ access_point_added_cb (NMDeviceWifi *device,
                        gpointer user_data)
 {
 	NMApplet *applet = NM_APPLET  (user_data);
-
-	add_hash_to_ap (ap);
-	g_signal_connect (G_OBJECT (ap),
-	                  "notify",
-	                  G_CALLBACK (notify_ap_prop_changed_cb),
-	                  applet);
+	WifiMenu *wmenu;
 
 	queue_avail_access_point_notification (NM_DEVICE (device));
-	applet_schedule_update_menu (applet);
+
+	if (applet->update_menu_id)
+		return;
+
+	wmenu = g_object_get_data (G_OBJECT (device), WIFI_MENU_TAG);
+	if (!wmenu || !wifi_menu_add_ap (wmenu, ap))
+		applet_schedule_update_menu (applet);
+	else
+		wifi_menu_update_header (wmenu);
 }
 
 static void
@@ -1130,6 +1282,7 @@ access_point_removed_cb (NMDeviceWifi *device,
 {
 	NMApplet *applet = NM_APPLET  (user_data);
 	NMAccessPoint *old;
+	WifiMenu *wmenu;
 
 	/* If this AP was the active AP, make sure ACTIVE_AP_TAG gets cleared from
 	 * its device.
@@ -1140,7 +1293,14 @@ access_point_removed_cb (NMDeviceWifi *device,
 		applet_schedule_update_icon (applet);
 	}
 
-	applet_schedule_update_menu (applet);
+	if (applet->update_menu_id)
+		return;
+
+	wmenu = g_object_get_data (G_OBJECT (device), WIFI_MENU_TAG);
+	if (!wmenu || !wifi_menu_remove_ap (wmenu, ap))
+		applet_schedule_update_menu (applet);
+	else
+		wifi_menu_update_header (wmenu);
 }
 
 static void
@@ -1170,8 +1330,6 @@ static void
 wifi_device_added (NMDevice *device, NMApplet *applet)
 {
 	NMDeviceWifi *wdev = NM_DEVICE_WIFI (device);
-	const GPtrArray *aps;
-	int i;
 	struct ap_notification_data *data;
 	guint id;
 
@@ -1209,11 +1367,6 @@ wifi_device_added (NMDevice *device, NMApplet *applet)
 	                        data, free_ap_notification_data);
 
 	queue_avail_access_point_notification (device);
-
-	/* Hash all APs this device knows about */
-	aps = nm_device_wifi_get_access_points (wdev);
-	for (i = 0; aps && (i < aps->len); i++)
-		add_hash_to_ap (g_ptr_array_index (aps, i));
 }
 
 static NMAccessPoint *
@@ -20,9 +20,14 @@
 #include <errno.h>
 
 #include "nma-vpn-password-dialog.h"
+#include "utils.h"
+#include "auth-dialog.h"
 #include "nm-utils/nm-compat.h"
 #include "nm-utils/nm-shared-utils.h"
 
+/* How long an auth-dialog that delivered its secrets gets to exit */
+#define AUTH_DIALOG_QUIT_TIMEOUT_SEC 5
+
 /*****************************************************************************/
 
 typedef struct {
@@ -38,10 +43,17 @@ typedef struct {
 	char *id;
 	char *service_type;
 
+	/* Set while queued on or served by a persistent auth-dialog */
+	AuthDialogPool *pool;
+	AuthDialogJob *job;
+	gboolean supports_hints;
+
 	guint watch_id;
 	GPid pid;
 
+	AuthDialogWriter *writer;
 	int child_stdout;
+	UtilsSecretsParser *parser;
 	GString *child_response;
 	GIOChannel *channel;
 	guint channel_eventid;
@@ -288,6 +300,14 @@ complete_request (VpnSecretsInfo *info)
 	applet_secrets_request_free (req);
 }
 
+static void
+child_secret_cb (const char *name, const char *value, gpointer user_data)
+{
+	RequestData *req_data = user_data;
+
+	g_variant_builder_add (&req_data->secrets_builder, "{ss}", name, value);
+}
+
 static void
 process_child_response (VpnSecretsInfo *info)
 {
@@ -301,16 +321,8 @@ process_child_response (VpnSecretsInfo *info)
 			applet_secrets_request_free (req);
 		}
 	} else {
-		char **lines = g_strsplit (req_data->child_response->str, "\n", -1);
-		int i;
-
-		for (i = 0; lines[i] && *(lines[i]); i += 2) {
-			if (lines[i + 1] == NULL)
-				break;
-			g_variant_builder_add (&req_data->secrets_builder, "{ss}", lines[i], lines[i + 1]);
-		}
-
-		g_strfreev (lines);
+		/* Picks up the last secret if output ended without the empty line */
+		utils_secrets_parser_finish (req_data->parser);
 		complete_request (info);
 	}
 }
@@ -339,6 +351,19 @@ child_finished_cb (GPid pid, int status, gpointer user_data)
 	}
 }
 
+static void
+child_stdin_written_cb (GError *error, gpointer user_data)
+{
+	VpnSecretsInfo *info = user_data;
+	SecretsRequest *req = (SecretsRequest *) info;
+
+	info->req_data->writer = NULL;
+	if (error) {
+		applet_secrets_request_complete (req, NULL, error);
+		applet_secrets_request_free (req);
+	}
+}
+
 static gboolean
 child_stdout_data_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
 {
@@ -366,7 +391,23 @@ child_stdout_data_cb (GIOChannel *source, GIOCondition condition, gpointer user_
 		}
 		return FALSE;
 	case G_IO_STATUS_NORMAL:
-		g_string_append_len (req_data->child_response, buf, bytes_read);
+		if (req_data->external_ui_mode) {
+			/* The keyfile has no terminator; it's parsed once complete */
+			g_string_append_len (req_data->child_response, buf, bytes_read);
+		} else if (utils_secrets_parser_feed (req_data->parser, buf, bytes_read, NULL)
+		           != UTILS_SECRETS_PARSER_MORE) {
+			/* The terminator is only printed on success, so all the
+			 * secrets are in. The child exits on the QUIT it was sent
+			 * and nobody needs to wait for that. */
+			req_data->channel_eventid = 0;
+			if (req_data->pid) {
+				nm_clear_g_source (&req_data->watch_id);
+				auth_dialog_release (req_data->pid, AUTH_DIALOG_QUIT_TIMEOUT_SEC);
+				req_data->pid = 0;
+			}
+			process_child_response (info);
+			return FALSE;
+		}
 		break;
 	default:
 		/* What just happened... */
@@ -378,46 +419,16 @@ child_stdout_data_cb (GIOChannel *source, GIOCondition condition, gpointer user_
 
 /*****************************************************************************/
 
-static void
-_str_append (GString *str,
-             const char *tag,
-             const char *val)
-{
-	const char *s;
-	gsize i;
-
-	nm_assert (str);
-	nm_assert (tag && tag[0]);
-	nm_assert (val);
-
-	g_string_append (str, tag);
-	g_string_append_c (str, '=');
-
-	s = strchr (val, '\n');
-	if (s) {
-		gs_free char *val2 = g_strdup (val);
-
-		for (i = 0; val2[i]; i++) {
-			if (val2[i] == '\n')
-				val2[i] = ' ';
-		}
-		g_string_append (str, val2);
-	} else
-		g_string_append (str, val);
-	g_string_append_c (str, '\n');
-}
-
-static char *
-connection_to_data (NMConnection *connection,
-                    gsize *out_length,
-                    GError **error)
+static gboolean
+writer_add_connection (AuthDialogWriter *writer,
+                       NMConnection *connection,
+                       GError **error)
 {
 	NMSettingVpn *s_vpn;
-	GString *buf;
 	const char **keys;
 	guint i, len;
 
-	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), FALSE);
 
 	s_vpn = nm_connection_get_setting_vpn (connection);
 	if (!s_vpn) {
@@ -425,80 +436,32 @@ connection_to_data (NMConnection *connection,
 		                     NM_SECRET_AGENT_ERROR,
 		                     NM_SECRET_AGENT_ERROR_FAILED,
 		                     _("Connection had no VPN setting"));
-		return NULL;
+		return FALSE;
 	}
 
-	buf = g_string_new_len (NULL, 100);
+	/* The lines point into the setting, even multi-megabyte inline certificates */
+	auth_dialog_writer_hold (writer, connection);
 
 	keys = nm_setting_vpn_get_data_keys (s_vpn, &len);
 	for (i = 0; i < len; i++) {
-		_str_append (buf, "DATA_KEY", keys[i]);
-		_str_append (buf, "DATA_VAL", nm_setting_vpn_get_data_item (s_vpn, keys[i]));
+		auth_dialog_writer_add_value (writer, "DATA_KEY", keys[i]);
+		auth_dialog_writer_add_value (writer, "DATA_VAL", nm_setting_vpn_get_data_item (s_vpn, keys[i]));
 	}
 	nm_clear_g_free (&keys);
 
 	keys = nm_setting_vpn_get_secret_keys (s_vpn, &len);
 	for (i = 0; i < len; i++) {
-		_str_append (buf, "SECRET_KEY", keys[i]);
-		_str_append (buf, "SECRET_VAL", nm_setting_vpn_get_secret (s_vpn, keys[i]));
+		auth_dialog_writer_add_value (writer, "SECRET_KEY", keys[i]);
+		auth_dialog_writer_add_value (writer, "SECRET_VAL", nm_setting_vpn_get_secret (s_vpn, keys[i]));
 	}
 	nm_clear_g_free (&keys);
 
-	g_string_append (buf, "DONE\n\nQUIT\n\n");
-	NM_SET_OUT (out_length, buf->len);
-	return g_string_free (buf, FALSE);
-}
-
-/*****************************************************************************/
-
-static gboolean
-connection_to_fd (NMConnection *connection,
-                  int fd,
-                  GError **error)
-{
-	gs_free char *data = NULL;
-	gsize data_len;
-	gssize w;
-	int errsv;
-
-	data = connection_to_data (connection, &data_len, error);
-	if (!data)
-		return FALSE;
-
-again:
-	w = write (fd, data, data_len);
-	if (w < 0) {
-		errsv = errno;
-		if (errsv == EINTR)
-			goto again;
-		g_set_error (error,
-		             NM_SECRET_AGENT_ERROR,
-		             NM_SECRET_AGENT_ERROR_FAILED,
-		             _("Failed to write connection to VPN UI: %s (%d)"), g_strerror (errsv), errsv);
-		return FALSE;
-	}
-
-	if ((gsize) w != data_len) {
-		g_set_error_literal (error,
-		                     NM_SECRET_AGENT_ERROR,
-		                     NM_SECRET_AGENT_ERROR_FAILED,
-		                     _("Failed to write connection to VPN UI: incomplete write"));
-		return FALSE;
-	}
-
+	auth_dialog_writer_add (writer, "DONE\n\n", 6);
 	return TRUE;
 }
 
 /*****************************************************************************/
 
-static void
-vpn_child_setup (gpointer user_data)
-{
-	/* We are in the child process at this point */
-	pid_t pid = getpid ();
-	setpgid (pid, pid);
-}
-
 static gboolean
 auth_dialog_spawn (const char *con_id,
                    const char *con_uuid,
@@ -516,8 +479,6 @@ auth_dialog_spawn (const char *con_id,
 	gsize hints_len;
 	gsize i, j;
 	gs_free const char **argv = NULL;
-	gs_free const char **envp = NULL;
-	gsize environ_len;
 
 	g_return_val_if_fail (con_id, FALSE);
 	g_return_val_if_fail (con_uuid, FALSE);
@@ -550,47 +511,98 @@ auth_dialog_spawn (const char *con_id,
 	nm_assert (i <= 10 + (2 * hints_len));
 	argv[i++] = NULL;
 
-	environ_len = NM_PTRARRAY_LEN (environ);
-	envp = g_new (const char *, environ_len + 1);
-	memcpy (envp, environ, sizeof (const char *) * environ_len);
-	for (i = 0, j = 0; i < environ_len; i++) {
-		const char *e = environ[i];
+	return auth_dialog_spawn_argv (argv, out_pid, out_stdin, out_stdout, error);
+}
+
+/*****************************************************************************/
 
-		if (g_str_has_prefix (e, "G_MESSAGES_DEBUG=")) {
-			/* skip this environment variable. We interact with the auth-dialog via stdout.
-			 * G_MESSAGES_DEBUG may enable additional debugging messages from GTK. */
-			continue;
-		}
-		envp[j++] = e;
+/* Plugins that set "supports-persistent-mode" in the [GNOME] section of their
+ * .name file get auth-dialogs that are kept running and serve one request
+ * after the other, instead of being spawned for every request. They are
+ * started with "-s <service> --persistent" and each request is written to
+ * their stdin as:
+ *
+ *   REQUEST
+ *   UUID=<connection uuid>
+ *   NAME=<connection id>
+ *   FLAGS=<NMSecretAgentGetSecretsFlags>
+ *   HINT=<hint>                (only if the plugin supports hints)
+ *   DATA_KEY=... DATA_VAL=... SECRET_KEY=... SECRET_VAL=...
+ *   DONE
+ *
+ * The answer and the rest of the protocol are described with
+ * AuthDialogPool. Each service type has a pool of its own, with no limit on
+ * the number of helpers, so a dialog that waits for the user doesn't hold up
+ * other VPN connections.
+ */
+
+#define VPN_HELPER_IDLE_TIMEOUT_SEC 600
+
+/* service type -> AuthDialogPool */
+static GHashTable *vpn_pools;
+
+static AuthDialogPool *
+vpn_pool_get (const char *service_type, const char *auth_dialog)
+{
+	AuthDialogPool *pool;
+	const char *argv[] = { auth_dialog, "-s", service_type, "--persistent", NULL };
+
+	if (!vpn_pools) {
+		vpn_pools = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                   g_free, (GDestroyNotify) auth_dialog_pool_free);
 	}
-	envp[j] = NULL;
-
-	if (!g_spawn_async_with_pipes (NULL,
-	                               (char **) argv,
-	                               (char **) envp,
-	                               G_SPAWN_DO_NOT_REAP_CHILD,
-	                               vpn_child_setup,
-	                               NULL,
-	                               out_pid,
-	                               out_stdin,
-	                               out_stdout,
-	                               NULL,
-	                               error))
-		return FALSE;
 
-	return TRUE;
+	pool = g_hash_table_lookup (vpn_pools, service_type);
+	if (!pool) {
+		pool = auth_dialog_pool_new (argv, 0, VPN_HELPER_IDLE_TIMEOUT_SEC * 1000);
+		g_hash_table_insert (vpn_pools, g_strdup (service_type), pool);
+	}
+	return pool;
 }
 
-/*****************************************************************************/
-
 static gboolean
-ensure_killed (gpointer data)
+vpn_job_write_cb (AuthDialogWriter *writer, gpointer user_data, GError **error)
 {
-	pid_t pid = GPOINTER_TO_INT (data);
+	VpnSecretsInfo *info = user_data;
+	SecretsRequest *req = (SecretsRequest *) info;
+	NMSettingConnection *s_con;
+	guint i;
 
-	kill (pid, SIGKILL);
-	waitpid (pid, NULL, 0);
-	return FALSE;
+	s_con = nm_connection_get_setting_connection (req->connection);
+
+	auth_dialog_writer_add (writer, "REQUEST\n", 8);
+	auth_dialog_writer_add_value (writer, "UUID", nm_setting_connection_get_uuid (s_con));
+	auth_dialog_writer_add_value (writer, "NAME", nm_setting_connection_get_id (s_con));
+	auth_dialog_writer_take (writer, g_strdup_printf ("FLAGS=%u\n", (guint) req->flags));
+	for (i = 0; info->req_data->supports_hints && req->hints && req->hints[i]; i++)
+		auth_dialog_writer_take_value (writer, "HINT", g_strdup (req->hints[i]));
+
+	return writer_add_connection (writer, req->connection, error);
+}
+
+static void
+vpn_job_secret_cb (const char *name, const char *value, gpointer user_data)
+{
+	VpnSecretsInfo *info = user_data;
+
+	g_variant_builder_add (&info->req_data->secrets_builder, "{ss}", name, value);
+}
+
+static void
+vpn_job_done_cb (GError *error, gpointer user_data)
+{
+	VpnSecretsInfo *info = user_data;
+
+	info->req_data->job = NULL;
+	info->req_data->pool = NULL;
+
+	if (!error) {
+		complete_request (info);
+		return;
+	}
+
+	applet_secrets_request_complete ((SecretsRequest *) info, NULL, error);
+	applet_secrets_request_free ((SecretsRequest *) info);
 }
 
 static void
@@ -618,19 +630,19 @@ free_vpn_secrets_info (SecretsRequest *req)
 
 	nm_clear_g_source (&req_data->watch_id);
 
+	auth_dialog_writer_free (req_data->writer);
+
 	nm_clear_g_source (&req_data->channel_eventid);
 	if (req_data->channel)
 		g_io_channel_unref (req_data->channel);
 
-	if (req_data->pid) {
-		if (kill (req_data->pid, SIGTERM) == 0)
-			g_timeout_add_seconds (2, ensure_killed, GINT_TO_POINTER (req_data->pid));
-		else {
-			kill (req_data->pid, SIGKILL);
-			waitpid (req_data->pid, NULL, 0);
-		}
-	}
+	if (req_data->job)
+		auth_dialog_pool_cancel (req_data->pool, req_data->job);
+
+	if (req_data->pid)
+		auth_dialog_kill (req_data->pid);
 
+	utils_secrets_parser_free (req_data->parser);
 	if (req_data->child_response)
 		g_string_free (req_data->child_response, TRUE);
 
@@ -712,6 +724,22 @@ applet_vpn_request_get_secrets (SecretsRequest *req, GError **error)
 		                                    "supports-external-ui-mode"),
 		FALSE);
 
+	/* Hand the request to a persistent auth-dialog if the plugin has one */
+	if (   !req_data->external_ui_mode
+	    && _nm_utils_ascii_str_to_bool (nm_vpn_plugin_info_lookup_property (plugin,
+	                                                                        "GNOME",
+	                                                                        "supports-persistent-mode"),
+	                                    FALSE)) {
+		req_data->supports_hints = nm_vpn_plugin_info_supports_hints (plugin);
+		req_data->pool = vpn_pool_get (service_type, auth_dialog);
+		req_data->job = auth_dialog_pool_submit (req_data->pool,
+		                                         vpn_job_write_cb,
+		                                         vpn_job_secret_cb,
+		                                         vpn_job_done_cb,
+		                                         info);
+		return TRUE;
+	}
+
 	if (!auth_dialog_spawn (nm_setting_connection_get_id (s_con),
 	                        nm_setting_connection_get_uuid (s_con),
 	                        (const char *const*) req->hints,
@@ -731,18 +759,26 @@ applet_vpn_request_get_secrets (SecretsRequest *req, GError **error)
 
 	/* listen to what child has to say */
 	req_data->channel = g_io_channel_unix_new (req_data->child_stdout);
-	req_data->child_response = g_string_sized_new (4096);
+	if (req_data->external_ui_mode)
+		req_data->child_response = g_string_sized_new (4096);
+	else
+		req_data->parser = utils_secrets_parser_new (FALSE, child_secret_cb, req_data);
 	req_data->channel_eventid = g_io_add_watch (req_data->channel,
 	                                            G_IO_IN  | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
 	                                            child_stdout_data_cb,
 	                                            info);
 
-	if (!connection_to_fd (req->connection, child_stdin, error))
-		return FALSE;
-	close (child_stdin);
-
 	g_io_channel_set_encoding (req_data->channel, NULL, NULL);
+	/* Parse the secrets as they come instead of waiting for 4k or EOF */
+	g_io_channel_set_buffered (req_data->channel, FALSE);
 
 	/* Dump parts of the connection to the child */
+	req_data->writer = auth_dialog_writer_new (child_stdin, TRUE);
+	if (!writer_add_connection (req_data->writer, req->connection, error))
+		return FALSE;
+	auth_dialog_writer_add (req_data->writer, "QUIT\n\n", 6);
+	if (!auth_dialog_writer_start (req_data->writer, child_stdin_written_cb, info, error))
+		return FALSE;
+
 	return TRUE;
 }
@@ -41,11 +41,32 @@
 extern gboolean shell_debug;
 extern gboolean with_agent;
 extern gboolean with_appindicator;
+extern guint icon_update_interval;
+extern gboolean startup_timing;
 
 G_DEFINE_TYPE (NMApplet, nma, G_TYPE_APPLICATION)
 
 /********************************************************************/
 
+/* Logs how long after startup @phase was reached, if requested with
+ * --startup-timing or NMA_STARTUP_TIMING.
+ */
+void
+applet_startup_phase (NMApplet *applet, const char *phase)
+{
+	gint64 now;
+
+	if (!startup_timing)
+		return;
+
+	now = g_get_monotonic_time ();
+	g_message ("startup: %-20s %9.1f ms (+%.1f ms)",
+	           phase,
+	           (now - applet->startup_time) / 1000.0,
+	           (now - MAX (applet->startup_phase_last, applet->startup_time)) / 1000.0);
+	applet->startup_phase_last = now;
+}
+
 static gboolean
 applet_request_wifi_scan (NMApplet *applet)
 {
@@ -53,6 +74,9 @@ applet_request_wifi_scan (NMApplet *applet)
 	NMDevice *device;
 	int i;
 
+	if (!applet->nm_client)
+		return G_SOURCE_CONTINUE;
+
 	g_debug ("requesting wifi scan");
 
 	/* Request scan for all wifi devices */
@@ -70,6 +94,11 @@ static void
 applet_start_wifi_scan (NMApplet *applet, gpointer unused)
 {
 	nm_clear_g_source (&applet->wifi_scan_id);
+
+	/* Nothing to scan with until the client is ready */
+	if (!applet->nm_client)
+		return;
+
 	applet->wifi_scan_id = g_timeout_add_seconds (15,
 	                                              (GSourceFunc) applet_request_wifi_scan,
 	                                              applet);
@@ -830,10 +859,18 @@ void applet_do_notify_with_pref (NMApplet *applet,
 	                  applet);
 }
 
+static void applet_animate_icon (NMApplet *applet);
+
 static gboolean
 animation_timeout (gpointer data)
 {
-	applet_schedule_update_icon (NM_APPLET (data));
+	NMApplet *applet = NM_APPLET (data);
+
+	applet->animation_step++;
+
+	/* A pending full update will pick up the new frame anyway */
+	if (!applet->update_icon_id)
+		applet_animate_icon (applet);
 	return TRUE;
 }
 
@@ -853,6 +890,7 @@ clear_animation_timeout (NMApplet *applet)
 		g_source_remove (applet->animation_id);
 		applet->animation_id = 0;
 		applet->animation_step = 0;
+		applet_schedule_update_icon (applet);
 	}
 }
 
@@ -1658,7 +1696,7 @@ static void nma_menu_show_cb (GtkWidget *menu, NMApplet *applet)
 	if (applet->status_icon)
 		gtk_status_icon_set_tooltip_text (applet->status_icon, NULL);
 
-	if (!nm_client_get_nm_running (applet->nm_client)) {
+	if (!applet->nm_client || !nm_client_get_nm_running (applet->nm_client)) {
 		nma_menu_add_text_item (menu, _("NetworkManager is not running…"));
 		return;
 	}
@@ -1731,6 +1769,14 @@ nma_context_menu_update (NMApplet *applet)
 	gboolean notifications_enabled = TRUE;
 	gboolean sensitive = FALSE;
 
+	if (!applet->nm_client) {
+		gtk_widget_set_sensitive (applet->info_menu_item, FALSE);
+		gtk_widget_set_sensitive (applet->networking_enabled_item, FALSE);
+		gtk_widget_set_sensitive (applet->wifi_enabled_item, FALSE);
+		gtk_widget_set_sensitive (applet->wwan_enabled_item, FALSE);
+		return;
+	}
+
 	state = nm_client_get_state (applet->nm_client);
 	sensitive = (   state == NM_STATE_CONNECTED_LOCAL
 	             || state == NM_STATE_CONNECTED_SITE
@@ -2102,10 +2148,23 @@ applet_schedule_update_menu (NMApplet *applet)
 
 /*****************************************************************************/
 
+static void
+icon_shown (NMApplet *applet)
+{
+	if (applet->icon_shown)
+		return;
+	applet->icon_shown = TRUE;
+
+	g_debug ("first status icon shown %.1f ms after startup",
+	         (g_get_monotonic_time () - applet->startup_time) / 1000.0);
+	applet_startup_phase (applet, "first icon");
+}
+
 static void
 foo_set_icon (NMApplet *applet, guint32 layer, GdkPixbuf *pixbuf, const char *icon_name)
 {
 	gs_unref_object GdkPixbuf *pixbuf_free = NULL;
+	gboolean by_name;
 
 	g_return_if_fail (layer == ICON_LAYER_LINK || layer == ICON_LAYER_VPN);
 
@@ -2117,15 +2176,24 @@ foo_set_icon (NMApplet *applet, guint32 layer, GdkPixbuf *pixbuf, const char *ic
 		 */
 		if (icon_name == NULL && layer == ICON_LAYER_LINK)
 			icon_name = "nm-no-connection";
-		if (icon_name != NULL && g_strcmp0 (app_indicator_get_icon (applet->app_indicator), icon_name) != 0)
+		if (icon_name != NULL && g_strcmp0 (app_indicator_get_icon (applet->app_indicator), icon_name) != 0) {
 			app_indicator_set_icon_full (applet->app_indicator, icon_name, applet->tip);
+			icon_shown (applet);
+		}
 		return;
 	}
 #endif  /* WITH_APPINDICATOR */
 
-	/* Load the pixbuf by icon name */
-	if (icon_name && !pixbuf)
+	/* Load the pixbuf by icon name, unless the layer already shows it */
+	by_name = icon_name && !pixbuf;
+	if (by_name) {
+		if (g_strcmp0 (applet->icon_layer_names[layer], icon_name) == 0)
+			return;
 		pixbuf = nma_icon_check_and_load (icon_name, applet);
+	}
+
+	g_free (applet->icon_layer_names[layer]);
+	applet->icon_layer_names[layer] = by_name ? g_strdup (icon_name) : NULL;
 
 	/* Ignore setting of the same icon as is already displayed */
 	if (applet->icon_layers[layer] == pixbuf)
@@ -2159,6 +2227,7 @@ foo_set_icon (NMApplet *applet, guint32 layer, GdkPixbuf *pixbuf, const char *ic
 		pixbuf = nma_icon_check_and_load ("nm-no-connection", applet);
 
 	gtk_status_icon_set_from_pixbuf (applet->status_icon, pixbuf);
+	icon_shown (applet);
 }
 
 NMRemoteConnection *
@@ -2264,10 +2333,32 @@ foo_device_state_changed_cb (NMDevice *device,
 	applet_schedule_update_menu (applet);
 }
 
+/* Whether the device can get entries in the main menu; must match the
+ * device types nma_menu_add_devices() adds.
+ */
+static gboolean
+device_has_menu_items (NMDevice *device)
+{
+	switch (nm_device_get_device_type (device)) {
+	case NM_DEVICE_TYPE_ETHERNET:
+	case NM_DEVICE_TYPE_WIFI:
+	case NM_DEVICE_TYPE_MODEM:
+	case NM_DEVICE_TYPE_BT:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static gboolean
+device_state_is_activating (NMDeviceState state)
+{
+	return state >= NM_DEVICE_STATE_PREPARE && state < NM_DEVICE_STATE_ACTIVATED;
+}
+
 static void
-foo_device_added_cb (NMClient *client, NMDevice *device, gpointer user_data)
+foo_device_register (NMDevice *device, NMApplet *applet)
 {
-	NMApplet *applet = NM_APPLET (user_data);
 	NMADeviceClass *dclass;
 
 	dclass = get_device_class (device, applet);
@@ -2276,9 +2367,44 @@ foo_device_added_cb (NMClient *client, NMDevice *device, gpointer user_data)
 
 	g_signal_connect (device, "state-changed",
 	                  G_CALLBACK (foo_device_state_changed_cb),
-	                  user_data);
+	                  applet);
+}
 
-	foo_device_state_changed_cb	(device,
+static void
+foo_deferred_device_state_changed_cb (NMDevice *device,
+                                      NMDeviceState new_state,
+                                      NMDeviceState old_state,
+                                      NMDeviceStateReason reason,
+                                      gpointer user_data)
+{
+	NMApplet *applet = NM_APPLET (user_data);
+
+	g_signal_handlers_disconnect_by_func (device,
+	                                      G_CALLBACK (foo_deferred_device_state_changed_cb),
+	                                      applet);
+	foo_device_register (device, applet);
+	foo_device_state_changed_cb (device, new_state, old_state, reason, applet);
+}
+
+static void
+foo_device_added_cb (NMClient *client, NMDevice *device, gpointer user_data)
+{
+	NMApplet *applet = NM_APPLET (user_data);
+
+	/* Devices that never show up in the menu (veth, loopback, ...) can be
+	 * numerous on container and VM hosts.  Only register them once they
+	 * change state, since that's the only time they can affect the icon.
+	 */
+	if (   !device_has_menu_items (device)
+	    && !device_state_is_activating (nm_device_get_state (device))) {
+		g_signal_connect (device, "state-changed",
+		                  G_CALLBACK (foo_deferred_device_state_changed_cb),
+		                  applet);
+		return;
+	}
+
+	foo_device_register (device, applet);
+	foo_device_state_changed_cb (device,
 	                             nm_device_get_state (device),
 	                             NM_DEVICE_STATE_UNKNOWN,
 	                             NM_DEVICE_STATE_REASON_NONE,
@@ -2308,6 +2434,20 @@ foo_client_state_changed_cb (NMClient *client, GParamSpec *pspec, gpointer user_
 static void
 foo_device_removed_cb (NMClient *client, NMDevice *device, NMApplet *applet)
 {
+	guint i;
+
+	for (i = 0; applet->initial_devices && i < applet->initial_devices->len; i++) {
+		if (g_ptr_array_index (applet->initial_devices, i) == device) {
+			if (i < applet->initial_devices_idx)
+				applet->initial_devices_idx--;
+			g_ptr_array_remove_index (applet->initial_devices, i);
+			break;
+		}
+	}
+
+	if (!INDICATOR_ENABLED (applet))
+		return;
+
 	applet_schedule_update_icon (applet);
 	applet_schedule_update_menu (applet);
 }
@@ -2395,32 +2535,99 @@ foo_wireless_enabled_changed_cb (NMClient *client, GParamSpec *pspec, NMApplet *
 	applet_schedule_update_menu (applet);
 }
 
+/* Time spent registering devices per main loop iteration at startup */
+#define INITIAL_STATE_BUDGET_US 4000
+
 static gboolean
 foo_set_initial_state (gpointer data)
 {
 	NMApplet *applet = NM_APPLET (data);
-	const GPtrArray *devices;
-	int i;
+	gint64 deadline;
+
+	deadline = g_get_monotonic_time () + INITIAL_STATE_BUDGET_US;
+	while (applet->initial_devices_idx < applet->initial_devices->len) {
+		foo_device_added_cb (applet->nm_client,
+		                     g_ptr_array_index (applet->initial_devices,
+		                                        applet->initial_devices_idx++),
+		                     applet);
+		if (g_get_monotonic_time () >= deadline)
+			break;
+	}
 
-	devices = nm_client_get_devices (applet->nm_client);
-	for (i = 0; devices && (i < devices->len); i++)
-		foo_device_added_cb (applet->nm_client, NM_DEVICE (g_ptr_array_index (devices, i)), applet);
+	if (applet->initial_devices_idx < applet->initial_devices->len)
+		return G_SOURCE_CONTINUE;
+
+	applet->initial_state_id = 0;
+	g_clear_pointer (&applet->initial_devices, g_ptr_array_unref);
 
 	foo_active_connections_changed_cb (applet->nm_client, NULL, applet);
 
 	applet_schedule_update_icon (applet);
+	applet_startup_phase (applet, "initial state");
 
-	return FALSE;
+	return G_SOURCE_REMOVE;
 }
 
 static void
-foo_client_setup (NMApplet *applet)
+foo_start_initial_state (NMApplet *applet)
+{
+	const GPtrArray *devices;
+	int i;
+
+	if (applet->initial_state_id)
+		return;
+
+	applet->initial_devices = g_ptr_array_new_with_free_func (g_object_unref);
+	applet->initial_devices_idx = 0;
+	devices = nm_client_get_devices (applet->nm_client);
+	for (i = 0; devices && (i < devices->len); i++)
+		g_ptr_array_add (applet->initial_devices, g_object_ref (g_ptr_array_index (devices, i)));
+
+	applet->initial_state_id = g_idle_add (foo_set_initial_state, applet);
+}
+
+static void register_agent (NMApplet *applet);
+
+static void
+foo_client_ready (GObject *source_object, GAsyncResult *result, gpointer user_data)
 {
+	NMApplet *applet;
+	NMClient *client;
 	NMClientPermission perm;
+	GError *error = NULL;
 
-	applet->nm_client = nm_client_new (NULL, NULL);
-	if (!applet->nm_client)
+	client = nm_client_new_finish (result, &error);
+	if (!client) {
+		/* On cancellation the applet is already gone */
+		if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			g_error_free (error);
+			return;
+		}
+
+		/* There's nothing useful the applet can do without a client */
+		applet = NM_APPLET (user_data);
+		g_warning ("Could not create NetworkManager client: %s", error->message);
+		g_error_free (error);
+		g_clear_object (&applet->nm_client_cancellable);
+		g_application_quit (G_APPLICATION (applet));
 		return;
+	}
+
+	applet = NM_APPLET (user_data);
+	g_clear_object (&applet->nm_client_cancellable);
+	applet->nm_client = client;
+	if (startup_timing) {
+		g_message ("startup: NMClient took %.1f ms",
+		           (g_get_monotonic_time () - applet->startup_client_requested) / 1000.0);
+	}
+	applet_startup_phase (applet, "client ready");
+
+	/* The secret agent needs the client to handle requests, so it is only
+	 * registered now; NetworkManager asks it for any secrets still needed. */
+	if (with_agent) {
+		register_agent (applet);
+		applet_startup_phase (applet, "agent");
+	}
 
 	g_signal_connect (applet->nm_client, "notify::state",
 	                  G_CALLBACK (foo_client_state_changed_cb),
@@ -2431,11 +2638,9 @@ foo_client_setup (NMApplet *applet)
 	g_signal_connect (applet->nm_client, "device-added",
 	                  G_CALLBACK (foo_device_added_cb),
 	                  applet);
-	if (INDICATOR_ENABLED (applet)) {
-		g_signal_connect (applet->nm_client, "device-removed",
-		                  G_CALLBACK (foo_device_removed_cb),
-		                  applet);
-	}
+	g_signal_connect (applet->nm_client, "device-removed",
+	                  G_CALLBACK (foo_device_removed_cb),
+	                  applet);
 	g_signal_connect (applet->nm_client, "notify::manager-running",
 	                  G_CALLBACK (foo_manager_running_cb),
 	                  applet);
@@ -2452,13 +2657,35 @@ foo_client_setup (NMApplet *applet)
 	                  G_CALLBACK (foo_wireless_enabled_changed_cb),
 	                  applet);
 
+	if (applet->agent && INDICATOR_ENABLED (applet)) {
+		/* Watch for new connections */
+		g_signal_connect_swapped (applet->nm_client, NM_CLIENT_CONNECTION_ADDED,
+		                          G_CALLBACK (applet_schedule_update_menu),
+		                          applet);
+	}
+
 	/* Initialize permissions - the initial 'permission-changed' signal is emitted from NMClient constructor, and thus not caught */
 	for (perm = NM_CLIENT_PERMISSION_NONE + 1; perm <= NM_CLIENT_PERMISSION_LAST; perm++) {
 		applet->permissions[perm] = nm_client_get_permission_result (applet->nm_client, perm);
 	}
 
 	if (nm_client_get_nm_running (applet->nm_client))
-		g_idle_add (foo_set_initial_state, applet);
+		foo_start_initial_state (applet);
+
+	applet_schedule_update_icon (applet);
+	applet_schedule_update_menu (applet);
+}
+
+/* The client is created asynchronously so that the status icon can be
+ * shown right away; until it is ready applet->nm_client is NULL and the
+ * icon shows the "no connection" placeholder.
+ */
+static void
+foo_client_setup (NMApplet *applet)
+{
+	applet->nm_client_cancellable = g_cancellable_new ();
+	applet->startup_client_requested = g_get_monotonic_time ();
+	nm_client_new_async (applet->nm_client_cancellable, foo_client_ready, applet);
 
 	applet_schedule_update_icon (applet);
 }
@@ -2476,7 +2703,8 @@ mm1_name_owner_changed_cb (GDBusObjectManagerClient *mm1,
 	applet->mm1_running = !!name_owner;
 	g_free (name_owner);
 
-	if (applet->mm1_running) {
+	/* Without a client yet, modems get registered with the initial state */
+	if (applet->mm1_running && applet->nm_client) {
 		const GPtrArray *devices;
 		NMADeviceClass *dclass;
 		NMDevice *device;
@@ -2505,6 +2733,7 @@ mm_new_ready (GDBusConnection *connection,
 	GError *error = NULL;
 
 	applet->mm1 = mm_manager_new_finish (res, &error);
+	applet_startup_phase (applet, "modem manager");
 	if (applet->mm1) {
 		/* We've got our MM proxy, now check whether the ModemManager
 		 * is really running and usable */
@@ -2565,18 +2794,15 @@ applet_common_get_device_icon (NMDeviceState state,
 	}
 
 	if (stage >= 0) {
-		char *name = g_strdup_printf ("nm-stage%02d-connecting%02d", stage + 1, applet->animation_step + 1);
+		const char *name;
+		GdkPixbuf *pixbuf;
 
+		pixbuf = applet_get_animation_frame (applet, ANIMATION_STAGE1 + stage, &name);
 		if (out_pixbuf)
-			*out_pixbuf = nm_g_object_ref (nma_icon_check_and_load (name, applet));
+			*out_pixbuf = nm_g_object_ref (pixbuf);
 		if (out_icon_name)
-			*out_icon_name = name;
-		else
-			g_free (name);
-
-		applet->animation_step++;
-		if (applet->animation_step >= NUM_CONNECTING_FRAMES)
-			applet->animation_step = 0;
+			*out_icon_name = g_strdup (name);
+		applet->layer_animations[ICON_LAYER_LINK] = ANIMATION_STAGE1 + stage;
 	}
 }
 
@@ -2700,6 +2926,7 @@ applet_update_icon (gpointer user_data)
 {
 	NMApplet *applet = NM_APPLET (user_data);
 	gs_unref_object GdkPixbuf *pixbuf = NULL;
+	GdkPixbuf *vpn_pixbuf = NULL;
 	NMState state;
 	const char *icon_name, *dev_tip;
 	char *vpn_tip = NULL;
@@ -2710,18 +2937,22 @@ applet_update_icon (gpointer user_data)
 	NMActiveConnection *active_vpn = NULL;
 
 	applet->update_icon_id = 0;
+	applet->update_icon_last = g_get_monotonic_time ();
+
+	nm_running = applet->nm_client && nm_client_get_nm_running (applet->nm_client);
 
-	nm_running = nm_client_get_nm_running (applet->nm_client);
+	applet->layer_animations[ICON_LAYER_LINK] = -1;
+	applet->layer_animations[ICON_LAYER_VPN] = -1;
 
 	/* Handle device state first */
 
-	state = nm_client_get_state (applet->nm_client);
-	if (!nm_running)
-		state = NM_STATE_UNKNOWN;
+	state = nm_running ? nm_client_get_state (applet->nm_client) : NM_STATE_UNKNOWN;
 
 #ifdef WITH_APPINDICATOR
+	/* Keep the placeholder icon shown while the client is being created */
 	if (INDICATOR_ENABLED (applet))
-		app_indicator_set_status (applet->app_indicator, nm_running ? APP_INDICATOR_STATUS_ACTIVE : APP_INDICATOR_STATUS_PASSIVE);
+		app_indicator_set_status (applet->app_indicator,
+		                          nm_running || !applet->nm_client ? APP_INDICATOR_STATUS_ACTIVE : APP_INDICATOR_STATUS_PASSIVE);
 	else
 #endif  /* WITH_APPINDICATOR */
 	{
@@ -2751,7 +2982,8 @@ applet_update_icon (gpointer user_data)
 	g_clear_pointer (&icon_name_free, g_free);
 
 	/* VPN state next */
-	active_vpn = applet_get_active_vpn_connection (applet, &vpn_state);
+	if (nm_running)
+		active_vpn = applet_get_active_vpn_connection (applet, &vpn_state);
 	if (active_vpn) {
 		switch (vpn_state) {
 		case NM_VPN_CONNECTION_STATE_ACTIVATED:
@@ -2765,10 +2997,8 @@ applet_update_icon (gpointer user_data)
 		case NM_VPN_CONNECTION_STATE_NEED_AUTH:
 		case NM_VPN_CONNECTION_STATE_CONNECT:
 		case NM_VPN_CONNECTION_STATE_IP_CONFIG_GET:
-			icon_name = icon_name_free = g_strdup_printf ("nm-vpn-connecting%02d", applet->animation_step + 1);
-			applet->animation_step++;
-			if (applet->animation_step >= NUM_VPN_CONNECTING_FRAMES)
-				applet->animation_step = 0;
+			vpn_pixbuf = applet_get_animation_frame (applet, ANIMATION_VPN, &icon_name);
+			applet->layer_animations[ICON_LAYER_VPN] = ANIMATION_VPN;
 			break;
 		default:
 			break;
@@ -2783,17 +3013,17 @@ applet_update_icon (gpointer user_data)
 			vpn_tip = tmp;
 		}
 	}
-	foo_set_icon (applet, ICON_LAYER_VPN, NULL, icon_name);
+	foo_set_icon (applet, ICON_LAYER_VPN, vpn_pixbuf, icon_name);
 
-	/* update tooltip */
+	/* update tooltip, if it changed */
+	if (!vpn_tip)
+		vpn_tip = (dev_tip == dev_tip_free) ? g_steal_pointer (&dev_tip_free) : g_strdup (dev_tip);
+	if (g_strcmp0 (applet->tip, vpn_tip) == 0) {
+		g_free (vpn_tip);
+		return FALSE;
+	}
 	g_free (applet->tip);
-	if (vpn_tip)
-		applet->tip = vpn_tip;
-	else if (dev_tip == dev_tip_free) {
-		applet->tip = dev_tip_free;
-		dev_tip_free = NULL;
-	} else
-		applet->tip = g_strdup (dev_tip);
+	applet->tip = vpn_tip;
 
 	if (applet->status_icon)
 		gtk_status_icon_set_tooltip_text (applet->status_icon, applet->tip);
@@ -2801,11 +3031,42 @@ applet_update_icon (gpointer user_data)
 	return FALSE;
 }
 
+/* Advances the animated icon layers to the current frame without
+ * re-evaluating the device and VPN state.
+ */
+static void
+applet_animate_icon (NMApplet *applet)
+{
+	GdkPixbuf *pixbuf;
+	const char *name;
+	int layer;
+
+	for (layer = 0; layer <= ICON_LAYER_MAX; layer++) {
+		if (applet->layer_animations[layer] < 0)
+			continue;
+		pixbuf = applet_get_animation_frame (applet, applet->layer_animations[layer], &name);
+		foo_set_icon (applet, layer, pixbuf, name);
+	}
+}
+
 void
 applet_schedule_update_icon (NMApplet *applet)
 {
-	if (!applet->update_icon_id)
+	gint64 now, next;
+
+	if (applet->update_icon_id)
+		return;
+
+	/* Coalesce bursts of changes into at most one update per interval */
+	now = g_get_monotonic_time ();
+	next = applet->update_icon_last + (gint64) icon_update_interval * 1000;
+	if (now >= next)
 		applet->update_icon_id = g_idle_add (applet_update_icon, applet);
+	else {
+		applet->update_icon_id = g_timeout_add (MAX ((next - now) / 1000, 1),
+		                                        applet_update_icon,
+		                                        applet);
+	}
 }
 
 /*****************************************************************************/
@@ -2951,6 +3212,9 @@ applet_agent_get_secrets_cb (AppletAgent *agent,
 	s_con = nm_connection_get_setting_connection (connection);
 	g_return_if_fail (s_con != NULL);
 
+	/* The agent is only registered once the client is ready */
+	nm_assert (applet->nm_client);
+
 	/* VPN secrets get handled a bit differently */
 	if (!strcmp (nm_setting_connection_get_connection_type (s_con), NM_SETTING_VPN_SETTING_NAME)) {
 		req = applet_secrets_request_new (applet_vpn_request_get_secrets_size (),
@@ -3042,12 +3306,19 @@ applet_agent_cancel_secrets_cb (AppletAgent *agent,
 
 static void nma_icons_free (NMApplet *applet)
 {
-	guint i;
+	guint i, j;
 
 	g_return_if_fail (NM_IS_APPLET (applet));
 
-	for (i = 0; i <= ICON_LAYER_MAX; i++)
+	for (i = 0; i <= ICON_LAYER_MAX; i++) {
 		g_clear_object (&applet->icon_layers[i]);
+		g_clear_pointer (&applet->icon_layer_names[i], g_free);
+	}
+
+	for (i = 0; i <= ANIMATION_MAX; i++) {
+		for (j = 0; j < applet->animations[i].n_frames; j++)
+			g_clear_object (&applet->animations[i].frames[j]);
+	}
 }
 
 GdkPixbuf *
@@ -3080,6 +3351,142 @@ nma_icon_check_and_load (const char *name, NMApplet *applet)
 	return icon;
 }
 
+static void
+nma_animations_init (NMApplet *applet)
+{
+	NMAAnimation *animation;
+	guint i, j;
+
+	for (i = ANIMATION_STAGE1; i <= ANIMATION_STAGE3; i++) {
+		animation = &applet->animations[i];
+		animation->n_frames = NUM_CONNECTING_FRAMES;
+		for (j = 0; j < animation->n_frames; j++)
+			animation->names[j] = g_strdup_printf ("nm-stage%02u-connecting%02u", i - ANIMATION_STAGE1 + 1, j + 1);
+	}
+
+	animation = &applet->animations[ANIMATION_VPN];
+	animation->n_frames = NUM_VPN_CONNECTING_FRAMES;
+	for (j = 0; j < animation->n_frames; j++)
+		animation->names[j] = g_strdup_printf ("nm-vpn-connecting%02u", j + 1);
+
+	for (i = 0; i <= ICON_LAYER_MAX; i++)
+		applet->layer_animations[i] = -1;
+}
+
+static void
+nma_animations_free (NMApplet *applet)
+{
+	guint i, j;
+
+	for (i = 0; i <= ANIMATION_MAX; i++) {
+		for (j = 0; j < applet->animations[i].n_frames; j++)
+			g_clear_pointer (&applet->animations[i].names[j], g_free);
+	}
+}
+
+/* Returns the current frame of @animation.  The frames of an animation are
+ * all loaded the first time it is shown after an icon theme (re)load, so that
+ * stepping through them later is just a matter of picking another pixbuf.
+ */
+GdkPixbuf *
+applet_get_animation_frame (NMApplet *applet, int animation, const char **out_icon_name)
+{
+	NMAAnimation *anim;
+	guint i;
+
+	g_return_val_if_fail (animation >= 0 && animation <= ANIMATION_MAX, NULL);
+
+	anim = &applet->animations[animation];
+	if (!anim->frames[0]) {
+		for (i = 0; i < anim->n_frames; i++)
+			anim->frames[i] = nm_g_object_ref (nma_icon_check_and_load (anim->names[i], applet));
+	}
+
+	i = applet->animation_step % anim->n_frames;
+	if (out_icon_name)
+		*out_icon_name = anim->names[i];
+	return anim->frames[i];
+}
+
+/* Icons likely to be needed right after login.  They are decoded in the
+ * background so that the first status icon update finds them in the cache.
+ */
+static const char *prefetch_icon_names[] = {
+	"nm-no-connection",
+	"nm-device-wired",
+	"nm-signal-00",
+	"nm-signal-25",
+	"nm-signal-50",
+	"nm-signal-75",
+	"nm-signal-100",
+	"nm-vpn-active-lock",
+};
+
+typedef struct {
+	NMApplet *applet;
+	GCancellable *cancellable;
+	char *name;
+} IconPrefetchData;
+
+static void
+icon_prefetch_done (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	IconPrefetchData *data = user_data;
+	NMApplet *applet = data->applet;
+	GError *error = NULL;
+	GdkPixbuf *icon;
+
+	icon = gtk_icon_info_load_icon_finish (GTK_ICON_INFO (source), result, &error);
+	if (g_cancellable_is_cancelled (data->cancellable)) {
+		/* Icon theme reloaded or applet gone */
+		g_clear_object (&icon);
+	} else if (!icon) {
+		/* Leave it to nma_icon_check_and_load() to fall back and warn */
+		g_debug ("failed to prefetch icon \"%s\": %s", data->name, error->message);
+	} else if (g_hash_table_contains (applet->icon_cache, data->name)) {
+		/* Already loaded on demand in the meantime */
+		g_object_unref (icon);
+	} else
+		g_hash_table_insert (applet->icon_cache, g_steal_pointer (&data->name), icon);
+
+	g_clear_error (&error);
+	g_object_unref (data->cancellable);
+	g_free (data->name);
+	g_slice_free (IconPrefetchData, data);
+}
+
+static void
+nma_icons_prefetch (NMApplet *applet)
+{
+	GtkIconInfo *info;
+	IconPrefetchData *data;
+	int scale;
+	guint i;
+
+	g_cancellable_cancel (applet->icon_prefetch_cancellable);
+	g_clear_object (&applet->icon_prefetch_cancellable);
+	applet->icon_prefetch_cancellable = g_cancellable_new ();
+
+	scale = gdk_window_get_scale_factor (gdk_get_default_root_window ());
+
+	for (i = 0; i < G_N_ELEMENTS (prefetch_icon_names); i++) {
+		info = gtk_icon_theme_lookup_icon_for_scale (applet->icon_theme,
+		                                             prefetch_icon_names[i],
+		                                             applet->icon_size,
+		                                             scale,
+		                                             GTK_ICON_LOOKUP_FORCE_SIZE);
+		if (!info)
+			continue;
+
+		data = g_slice_new0 (IconPrefetchData);
+		data->applet = applet;
+		data->cancellable = g_object_ref (applet->icon_prefetch_cancellable);
+		data->name = g_strdup (prefetch_icon_names[i]);
+		gtk_icon_info_load_icon_async (info, data->cancellable, icon_prefetch_done, data);
+		g_object_unref (info);
+	}
+}
+
 #include "fallback-icon.h"
 
 static void
@@ -3091,7 +3498,9 @@ nma_icons_reload (NMApplet *applet)
 	g_return_if_fail (applet->icon_size > 0);
 
 	g_hash_table_remove_all (applet->icon_cache);
+	g_hash_table_remove_all (applet->status_pixbuf_cache);
 	nma_icons_free (applet);
+	nma_icons_prefetch (applet);
 
 	if (applet->fallback_icon)
 		return;
@@ -3317,13 +3726,6 @@ register_agent (NMApplet *applet)
 	                  G_CALLBACK (applet_agent_get_secrets_cb), applet);
 	g_signal_connect (applet->agent, APPLET_AGENT_CANCEL_SECRETS,
 	                  G_CALLBACK (applet_agent_cancel_secrets_cb), applet);
-
-	if (INDICATOR_ENABLED (applet)) {
-		/* Watch for new connections */
-		g_signal_connect_swapped (applet->nm_client, NM_CLIENT_CONNECTION_ADDED,
-		                          G_CALLBACK (applet_schedule_update_menu),
-		                          applet);
-	}
 }
 
 static void
@@ -3356,6 +3758,8 @@ applet_startup (GApplication *app, gpointer user_data)
 	NMApplet *applet = NM_APPLET (app);
 	gs_free_error GError *error = NULL;
 
+	applet->startup_time = g_get_monotonic_time ();
+
 	g_set_application_name (_("NetworkManager Applet"));
 	gtk_window_set_default_icon_name ("network-workgroup");
 
@@ -3366,13 +3770,17 @@ applet_startup (GApplication *app, gpointer user_data)
 		g_application_quit (app);
 		return;
 	}
+	applet_startup_phase (applet, "info dialog");
 
 	applet->gsettings = g_settings_new (APPLET_PREFS_SCHEMA);
 	applet->visible = g_settings_get_boolean (applet->gsettings, PREF_SHOW_APPLET);
 	g_signal_connect (applet->gsettings, "changed::show-applet",
 	                  G_CALLBACK (applet_gsettings_show_changed), applet);
+	applet_startup_phase (applet, "settings");
 
+	/* Only starts creating the client; see "client ready" for the rest */
 	foo_client_setup (applet);
+	applet_startup_phase (applet, "client requested");
 
 	/* Load pixmaps and create applet widgets */
 	if (!setup_widgets (applet)) {
@@ -3381,12 +3789,18 @@ applet_startup (GApplication *app, gpointer user_data)
 		return;
 	}
 	g_assert (INDICATOR_ENABLED (applet) || applet->status_icon);
+	applet_startup_phase (applet, "widgets");
 
 	applet->icon_cache = g_hash_table_new_full (g_str_hash,
 	                                            g_str_equal,
 	                                            g_free,
 	                                            nm_g_object_unref);
+	applet->status_pixbuf_cache = g_hash_table_new_full (g_direct_hash,
+	                                                     g_direct_equal,
+	                                                     NULL,
+	                                                     g_object_unref);
 	nma_icons_init (applet);
+	applet_startup_phase (applet, "icons");
 
 	if (!notify_is_initted ())
 		notify_init ("NetworkManager");
@@ -3419,9 +3833,7 @@ applet_startup (GApplication *app, gpointer user_data)
 		applet_embedded_cb (G_OBJECT (applet->status_icon), NULL, NULL);
 	}
 
-	if (with_agent)
-		register_agent (applet);
-
+	applet_startup_phase (applet, "startup done");
 	g_application_hold (G_APPLICATION (applet));
 }
 
@@ -3436,7 +3848,14 @@ static void finalize (GObject *object)
 #endif
 	g_slice_free (NMADeviceClass, applet->bt_class);
 
+	g_cancellable_cancel (applet->nm_client_cancellable);
+	g_clear_object (&applet->nm_client_cancellable);
+	nm_clear_g_source (&applet->initial_state_id);
+	g_clear_pointer (&applet->initial_devices, g_ptr_array_unref);
 	nm_clear_g_source (&applet->update_icon_id);
+	nm_clear_g_source (&applet->animation_id);
+	g_cancellable_cancel (applet->icon_prefetch_cancellable);
+	g_clear_object (&applet->icon_prefetch_cancellable);
 	nm_clear_g_source (&applet->wifi_scan_id);
 
 #ifdef WITH_APPINDICATOR
@@ -3447,9 +3866,11 @@ static void finalize (GObject *object)
 	g_clear_object (&applet->status_icon);
 	g_clear_object (&applet->menu);
 	g_clear_pointer (&applet->icon_cache, g_hash_table_destroy);
+	g_clear_pointer (&applet->status_pixbuf_cache, g_hash_table_destroy);
 	g_clear_object (&applet->fallback_icon);
 	g_free (applet->tip);
 	nma_icons_free (applet);
+	nma_animations_free (applet);
 
 	while (g_slist_length (applet->secrets_reqs))
 		applet_secrets_request_free ((SecretsRequest *) applet->secrets_reqs->data);
@@ -3475,6 +3896,7 @@ static void finalize (GObject *object)
 static void nma_init (NMApplet *applet)
 {
 	applet->icon_size = 16;
+	nma_animations_init (applet);
 
 	g_signal_connect (applet, "startup", G_CALLBACK (applet_startup), NULL);
 	g_signal_connect (applet, "activate", G_CALLBACK (applet_activate), NULL);
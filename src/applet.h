@@ -62,6 +62,27 @@ typedef struct {
 #define ICON_LAYER_VPN                            1
 #define ICON_LAYER_MAX                            ICON_LAYER_VPN
 
+/* Minimum time between two status icon updates, in milliseconds */
+#define APPLET_ICON_UPDATE_INTERVAL               50
+
+/* Connecting animations: one per device activation stage, plus VPN */
+#define ANIMATION_STAGE1                          0
+#define ANIMATION_STAGE2                          1
+#define ANIMATION_STAGE3                          2
+#define ANIMATION_VPN                             3
+#define ANIMATION_MAX                             ANIMATION_VPN
+
+#define NUM_CONNECTING_FRAMES                     11
+#define NUM_VPN_CONNECTING_FRAMES                 14
+#define ANIMATION_MAX_FRAMES                      NUM_VPN_CONNECTING_FRAMES
+
+typedef struct {
+	guint           n_frames;
+	char *          names[ANIMATION_MAX_FRAMES];
+	/* Loaded from the current icon theme on first use */
+	GdkPixbuf *     frames[ANIMATION_MAX_FRAMES];
+} NMAAnimation;
+
 typedef struct NMADeviceClass NMADeviceClass;
 
 /*
@@ -72,6 +93,7 @@ typedef struct {
 	GApplication parent;
 
 	NMClient *nm_client;
+	GCancellable *nm_client_cancellable;
 	AppletAgent *agent;
 
 	GSettings *gsettings;
@@ -94,23 +116,39 @@ typedef struct {
 #endif
 	NMADeviceClass *bt_class;
 
+	/* Startup time, for measuring how long until the first icon shows */
+	gint64          startup_time;
+	gint64          startup_phase_last;
+	gint64          startup_client_requested;
+	gboolean        icon_shown;
+
+	/* Devices still waiting for their initial registration */
+	GPtrArray *     initial_devices;
+	guint           initial_devices_idx;
+	guint           initial_state_id;
+
 	/* Data model elements */
 	guint           update_icon_id;
+	gint64          update_icon_last;
 	char *          tip;
 
 	/* Animation stuff */
-	int             animation_step;
+	guint           animation_step;
 	guint           animation_id;
-#define NUM_CONNECTING_FRAMES 11
-#define NUM_VPN_CONNECTING_FRAMES 14
+	NMAAnimation    animations[ANIMATION_MAX + 1];
+	/* Animation shown by each icon layer, or -1 */
+	int             layer_animations[ICON_LAYER_MAX + 1];
 
 	GtkIconTheme *  icon_theme;
 	GHashTable *    icon_cache;
+	GHashTable *    status_pixbuf_cache;
+	GCancellable *  icon_prefetch_cancellable;
 	GdkPixbuf *     fallback_icon;
 	int             icon_size;
 
-	/* Active status icon pixbufs */
+	/* Active status icon pixbufs and the names they were loaded by */
 	GdkPixbuf *     icon_layers[ICON_LAYER_MAX + 1];
+	char *          icon_layer_names[ICON_LAYER_MAX + 1];
 
 	/* Direct UI elements */
 #ifdef WITH_APPINDICATOR
@@ -280,9 +318,15 @@ GtkWidget * applet_new_menu_item_helper (NMConnection *connection,
                                          NMConnection *active,
                                          gboolean add_active);
 
+void applet_startup_phase (NMApplet *applet, const char *phase);
+
 GdkPixbuf * nma_icon_check_and_load (const char *name,
                                      NMApplet *applet);
 
+GdkPixbuf * applet_get_animation_frame (NMApplet *applet,
+                                        int animation,
+                                        const char **out_icon_name);
+
 gboolean applet_wifi_connect_to_hidden_network (NMApplet *applet);
 gboolean applet_wifi_create_wifi_network (NMApplet *applet);
 gboolean applet_wifi_can_create_wifi_network (NMApplet *applet);
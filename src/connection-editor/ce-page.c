@@ -598,39 +598,32 @@ invalid:
 char *
 ce_page_get_next_available_name (const GPtrArray *connections, const char *format)
 {
-	GSList *names = NULL, *iter;
+	gs_unref_hashtable GHashTable *names = NULL;
 	char *cname = NULL;
 	int i = 0;
 
+	names = g_hash_table_new (g_str_hash, g_str_equal);
 	for (i = 0; i < connections->len; i++) {
 		const char *id;
 
 		id = nm_connection_get_id (connections->pdata[i]);
 		g_assert (id);
-		names = g_slist_append (names, (gpointer) id);
+		g_hash_table_add (names, (gpointer) id);
 	}
 
 	/* Find the next available unique connection name */
 	for (i = 1; !cname && i < 10000; i++) {
 		char *temp;
-		gboolean found = FALSE;
 
 		NM_PRAGMA_WARNING_DISABLE("-Wformat-nonliteral")
 		temp = g_strdup_printf (format, i);
 		NM_PRAGMA_WARNING_REENABLE
-		for (iter = names; iter; iter = g_slist_next (iter)) {
-			if (!strcmp (iter->data, temp)) {
-				found = TRUE;
-				break;
-			}
-		}
-		if (!found)
+		if (!g_hash_table_contains (names, temp))
 			cname = temp;
 		else
 			g_free (temp);
 	}
 
-	g_slist_free (names);
 	return cname;
 }
 
@@ -692,6 +685,97 @@ out:
 	g_signal_emit (self, signals[INITIALIZED], 0, NULL);
 }
 
+/* Pages of a type that gets opened repeatedly, such as port editors
+ * opened from the master's page, take a GtkBuilder that was parsed ahead of
+ * time from an idle handler. GTK can only be used from the main thread,
+ * so that's where the parsing happens too, but not while the user waits
+ * for the editor to open.
+ *
+ * Only resources that were used more than once get a spare and there are
+ * at most MAX_SPARE_BUILDERS of them. They outlive the editor that used
+ * them, so that the next editor for the same kind of connection opens
+ * faster too.
+ */
+#define MAX_SPARE_BUILDERS 4
+
+typedef struct {
+	guint uses;
+	GtkBuilder *spare;
+} UiCacheEntry;
+
+/* UI resource path -> UiCacheEntry */
+static GHashTable *ui_cache;
+static guint n_spare_builders;
+
+static void
+ui_cache_entry_free (gpointer data)
+{
+	UiCacheEntry *entry = data;
+
+	if (entry->spare) {
+		g_object_unref (entry->spare);
+		n_spare_builders--;
+	}
+	g_slice_free (UiCacheEntry, entry);
+}
+
+static gboolean
+refill_spare_builder (gpointer user_data)
+{
+	const char *ui_resource = user_data;
+	UiCacheEntry *entry;
+	GtkBuilder *builder;
+
+	/* Refilled already, or enough spares around */
+	entry = g_hash_table_lookup (ui_cache, ui_resource);
+	if (entry->spare || n_spare_builders >= MAX_SPARE_BUILDERS)
+		return G_SOURCE_REMOVE;
+
+	builder = gtk_builder_new ();
+	if (gtk_builder_add_from_resource (builder, ui_resource, NULL)) {
+		entry->spare = builder;
+		n_spare_builders++;
+	} else
+		g_object_unref (builder);
+	return G_SOURCE_REMOVE;
+}
+
+static GtkBuilder *
+take_builder (const char *ui_resource, GError **error)
+{
+	UiCacheEntry *entry;
+	GtkBuilder *builder;
+	gint64 start = g_get_monotonic_time ();
+
+	if (!ui_cache)
+		ui_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, ui_cache_entry_free);
+
+	entry = g_hash_table_lookup (ui_cache, ui_resource);
+	if (!entry) {
+		entry = g_slice_new0 (UiCacheEntry);
+		g_hash_table_insert (ui_cache, g_strdup (ui_resource), entry);
+	}
+	entry->uses++;
+
+	if (entry->spare) {
+		builder = g_steal_pointer (&entry->spare);
+		n_spare_builders--;
+	} else {
+		builder = gtk_builder_new ();
+		if (!gtk_builder_add_from_resource (builder, ui_resource, error)) {
+			g_object_unref (builder);
+			return NULL;
+		}
+		g_debug ("Parsing %s took %.1f ms",
+		         ui_resource,
+		         (g_get_monotonic_time () - start) / 1000.0);
+	}
+
+	if (entry->uses > 1)
+		g_idle_add_full (G_PRIORITY_LOW, refill_spare_builder, g_strdup (ui_resource), g_free);
+	return builder;
+}
+
 static void
 ce_page_init (CEPage *self)
 {
@@ -736,6 +820,22 @@ ce_page_get_title (CEPage *self)
 	return self->title;
 }
 
+/* Returns the title that pages of @page_type have if they don't set one
+ * of their own, without constructing a page. */
+const char *
+ce_page_type_get_title (GType page_type)
+{
+	CEPageClass *page_class;
+	const char *title;
+
+	g_return_val_if_fail (g_type_is_a (page_type, CE_TYPE_PAGE), NULL);
+
+	page_class = g_type_class_ref (page_type);
+	title = page_class->title;
+	g_type_class_unref (page_class);
+	return title;
+}
+
 void
 ce_page_changed (CEPage *self)
 {
@@ -897,6 +997,8 @@ ce_page_new (GType page_type,
 	CEPage *self;
 	GError *error = NULL;
 
+	if (!title)
+		title = ce_page_type_get_title (page_type);
 	g_return_val_if_fail (title != NULL, NULL);
 	if (ui_resource)
 		g_return_val_if_fail (widget_name != NULL, NULL);
@@ -910,7 +1012,9 @@ ce_page_new (GType page_type,
 	self->editor = editor;
 
 	if (ui_resource) {
-		if (!gtk_builder_add_from_resource (self->builder, ui_resource, &error)) {
+		g_object_unref (self->builder);
+		self->builder = take_builder (ui_resource, &error);
+		if (!self->builder) {
 			g_warning ("Couldn't load builder resource: %s", error->message);
 			g_error_free (error);
 			g_object_unref (self);
@@ -78,6 +78,9 @@ typedef struct {
 typedef struct {
 	GObjectClass parent;
 
+	/* Tab title, so that a tab can be shown before the page is constructed */
+	const char *title;
+
 	/* Virtual functions */
 	gboolean    (*ce_page_validate_v) (CEPage *self, NMConnection *connection, GError **error);
 	gboolean    (*last_update)  (CEPage *self, NMConnection *connection, GError **error);
@@ -111,6 +114,8 @@ GtkWidget *  ce_page_get_page (CEPage *self);
 
 const char * ce_page_get_title (CEPage *self);
 
+const char * ce_page_type_get_title (GType page_type);
+
 gboolean ce_page_validate (CEPage *self, NMConnection *connection, GError **error);
 gboolean ce_page_last_update (CEPage *self, NMConnection *connection, GError **error);
 gboolean ce_page_inter_page_change (CEPage *self);
@@ -67,6 +67,10 @@ static guint editor_signals[EDITOR_LAST_SIGNAL] = { 0 };
 
 static GHashTable *active_editors;
 
+/* UUID and interface name of the edited connections -> NMConnectionEditor */
+static GHashTable *editors_by_uuid;
+static GHashTable *editors_by_iface;
+
 static gboolean nm_connection_editor_set_connection (NMConnectionEditor *editor,
                                                      NMConnection *connection,
                                                      GError **error);
@@ -75,11 +79,18 @@ struct GetSecretsInfo {
 	NMConnectionEditor *self;
 	CEPage *page;
 	char *setting_name;
-	gboolean canceled;
+	GCancellable *cancellable;
+	gint64 start_time;
 };
 
 #define SECRETS_TAG "secrets-setting-name"
 #define ORDER_TAG "page-order"
+#define LAZY_TAG "page-new-func"
+
+/* The notebook starts out on the connection-type-specific page, which
+ * comes right after "General" */
+#define FIRST_SHOWN_PAGE 1
+#define PLACEHOLDER_TAG "page-placeholder"
 
 static void
 nm_connection_editor_update_title (NMConnectionEditor *editor)
@@ -338,6 +349,17 @@ connection_editor_validate (NMConnectionEditor *editor)
 		goto done_silent;
 	}
 
+	/* Don't save until all pages have their secrets */
+	if (editor->secrets_calls) {
+		validation_error = g_strdup (_("Retrieving secrets…"));
+		goto done_silent;
+	}
+	if (editor->secrets_pages) {
+		validation_error = g_strdup_printf (_("Secrets for the “%s” page could not be retrieved"),
+		                                    ce_page_get_title (editor->secrets_pages->data));
+		goto done;
+	}
+
 	s_con = nm_connection_get_setting_connection (editor->connection);
 	g_assert (s_con);
 	if (nm_setting_connection_get_read_only (s_con)) {
@@ -454,11 +476,53 @@ nm_connection_editor_init (NMConnectionEditor *editor)
 	gtk_builder_connect_signals (editor->builder, editor);
 
 	editor->inter_page_hash = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) destroy_inter_page_item);
+	editor->inter_page_last = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+static void
+editor_index_remove (NMConnectionEditor *editor)
+{
+	if (   editor->indexed_uuid
+	    && g_hash_table_lookup (editors_by_uuid, editor->indexed_uuid) == editor)
+		g_hash_table_remove (editors_by_uuid, editor->indexed_uuid);
+	if (   editor->indexed_iface
+	    && g_hash_table_lookup (editors_by_iface, editor->indexed_iface) == editor)
+		g_hash_table_remove (editors_by_iface, editor->indexed_iface);
+
+	nm_clear_g_free (&editor->indexed_uuid);
+	nm_clear_g_free (&editor->indexed_iface);
+}
+
+static void
+editor_index_update (NMConnectionEditor *editor)
+{
+	const char *uuid, *iface;
+
+	editor_index_remove (editor);
+
+	if (!editors_by_uuid) {
+		editors_by_uuid = g_hash_table_new (g_str_hash, g_str_equal);
+		editors_by_iface = g_hash_table_new (g_str_hash, g_str_equal);
+	}
+
+	uuid = nm_connection_get_uuid (editor->orig_connection);
+	if (uuid) {
+		editor->indexed_uuid = g_strdup (uuid);
+		g_hash_table_insert (editors_by_uuid, editor->indexed_uuid, editor);
+	}
+
+	iface = nm_connection_get_interface_name (editor->orig_connection);
+	if (iface) {
+		editor->indexed_iface = g_strdup (iface);
+		g_hash_table_insert (editors_by_iface, editor->indexed_iface, editor);
+	}
 }
 
 static void
 get_secrets_info_free (GetSecretsInfo *info)
 {
+	g_clear_object (&info->page);
+	g_clear_object (&info->cancellable);
 	g_free (info->setting_name);
 	g_free (info);
 }
@@ -473,19 +537,27 @@ dispose (GObject *object)
 	if (active_editors && editor->orig_connection)
 		g_hash_table_remove (active_editors, editor->orig_connection);
 
+	editor_index_remove (editor);
+	if (editor->orig_connection)
+		g_signal_handlers_disconnect_by_func (editor->orig_connection, editor_index_update, editor);
+
 	g_slist_free_full (editor->initializing_pages, g_object_unref);
 	editor->initializing_pages = NULL;
 
 	g_slist_free_full (editor->pages, g_object_unref);
 	editor->pages = NULL;
 
-	/* Mark any in-progress secrets call as canceled; it will clean up after itself. */
-	if (editor->secrets_call)
-		editor->secrets_call->canceled = TRUE;
+	g_slist_free_full (editor->secrets_pages, g_object_unref);
+	editor->secrets_pages = NULL;
+
+	/* Placeholders are owned by the notebook */
+	g_slist_free (editor->lazy_pages);
+	editor->lazy_pages = NULL;
 
-	while (editor->pending_secrets_calls) {
-		get_secrets_info_free ((GetSecretsInfo *) editor->pending_secrets_calls->data);
-		editor->pending_secrets_calls = g_slist_delete_link (editor->pending_secrets_calls, editor->pending_secrets_calls);
+	/* Cancel in-progress secrets calls; they will clean up after themselves. */
+	while (editor->secrets_calls) {
+		g_cancellable_cancel (((GetSecretsInfo *) editor->secrets_calls->data)->cancellable);
+		editor->secrets_calls = g_slist_delete_link (editor->secrets_calls, editor->secrets_calls);
 	}
 
 	nm_clear_g_source (&editor->validate_id);
@@ -509,6 +581,7 @@ dispose (GObject *object)
 		g_hash_table_destroy (editor->inter_page_hash);
 		editor->inter_page_hash = NULL;
 	}
+	g_clear_pointer (&editor->inter_page_last, g_hash_table_destroy);
 
 	g_slist_free_full (editor->unsupported_properties, g_free);
 	editor->unsupported_properties = NULL;
@@ -595,6 +668,11 @@ nm_connection_editor_new (GtkWindow *parent_window,
 		active_editors = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 	g_hash_table_insert (active_editors, g_object_ref (connection), editor);
 
+	/* The interface name changes when the connection gets saved */
+	editor_index_update (editor);
+	g_signal_connect_swapped (connection, NM_CONNECTION_CHANGED,
+	                          G_CALLBACK (editor_index_update), editor);
+
 	return editor;
 }
 
@@ -608,12 +686,11 @@ nm_connection_editor_get (NMConnection *connection)
 NMConnectionEditor *
 nm_connection_editor_get_master (NMConnection *port)
 {
-	GHashTableIter iter;
-	gpointer connection, editor;
 	NMSettingConnection *s_con;
+	NMConnectionEditor *editor;
 	const char *master;
 
-	if (!active_editors)
+	if (!editors_by_uuid)
 		return NULL;
 
 	s_con = nm_connection_get_setting_connection (port);
@@ -621,15 +698,10 @@ nm_connection_editor_get_master (NMConnection *port)
 	if (!master)
 		return NULL;
 
-	g_hash_table_iter_init (&iter, active_editors);
-	while (g_hash_table_iter_next (&iter, &connection, &editor)) {
-		if (!g_strcmp0 (master, nm_connection_get_uuid (connection)))
-			return editor;
-		if (!g_strcmp0 (master, nm_connection_get_interface_name (connection)))
-			return editor;
-	}
-
-	return NULL;
+	editor = g_hash_table_lookup (editors_by_uuid, master);
+	if (!editor)
+		editor = g_hash_table_lookup (editors_by_iface, master);
+	return editor;
 }
 
 NMConnection *
@@ -698,7 +770,7 @@ recheck_initialization (NMConnectionEditor *editor)
 
 	/* Show the second page (the connection-type-specific data) first */
 	notebook = GTK_NOTEBOOK (gtk_builder_get_object (editor->builder, "notebook"));
-	gtk_notebook_set_current_page (notebook, 1);
+	gtk_notebook_set_current_page (notebook, FIRST_SHOWN_PAGE);
 
 	/* When everything is initialized, re-present the window to ensure it's on top */
 	nm_connection_editor_present (editor);
@@ -733,34 +805,50 @@ recheck_initialization (NMConnectionEditor *editor)
 }
 
 static void
-page_initialized (CEPage *page, GError *error, gpointer user_data)
+editor_init_failed (NMConnectionEditor *editor, GError *error)
+{
+	gtk_widget_hide (editor->window);
+	nm_connection_editor_error (editor->parent_window,
+	                            _("Error initializing editor"),
+	                            "%s",
+	                            error ? error->message : _("Unknown error creating connection editor dialog."));
+	g_signal_emit (editor, editor_signals[EDITOR_DONE], 0, GTK_RESPONSE_NONE);
+}
+
+static void
+inter_page_replay (NMConnectionEditor *editor, CEPage *page)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (!g_hash_table_size (editor->inter_page_last))
+		return;
+
+	/* Let a page constructed late see the inter-page values the other
+	 * pages have set so far.
+	 */
+	g_hash_table_iter_init (&iter, editor->inter_page_last);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_hash_table_insert (editor->inter_page_hash, key, value);
+
+	ce_page_inter_page_change (page);
+
+	if (editor_is_initialized (editor))
+		nm_connection_editor_inter_page_clear_data (editor);
+}
+
+static void
+notebook_insert_ordered (NMConnectionEditor *editor,
+                         GtkWidget *widget,
+                         const char *title,
+                         gpointer order)
 {
-	NMConnectionEditor *editor = NM_CONNECTION_EDITOR (user_data);
-	GtkWidget *widget, *parent;
 	GtkNotebook *notebook;
-	GtkWidget *label;
 	GList *children, *iter;
-	gpointer order, child_order;
+	gpointer child_order;
 	int i;
 
-	if (error) {
-		gtk_widget_hide (editor->window);
-		nm_connection_editor_error (editor->parent_window,
-		                            _("Error initializing editor"),
-		                            "%s", error->message);
-		g_signal_emit (editor, editor_signals[EDITOR_DONE], 0, GTK_RESPONSE_NONE);
-		return;
-	}
-
-	/* Add the page to the UI */
 	notebook = GTK_NOTEBOOK (gtk_builder_get_object (editor->builder, "notebook"));
-	label = gtk_label_new (ce_page_get_title (page));
-	widget = ce_page_get_page (page);
-	parent = gtk_widget_get_parent (widget);
-	if (parent)
-		gtk_container_remove (GTK_CONTAINER (parent), widget);
-
-	order = g_object_get_data (G_OBJECT (page), ORDER_TAG);
 	g_object_set_data (G_OBJECT (widget), ORDER_TAG, order);
 
 	children = gtk_container_get_children (GTK_CONTAINER (notebook));
@@ -771,15 +859,102 @@ page_initialized (CEPage *page, GError *error, gpointer user_data)
 	}
 	g_list_free (children);
 
-	gtk_notebook_insert_page (notebook, widget, label, i);
+	gtk_notebook_insert_page (notebook, widget, gtk_label_new (title), i);
+}
+
+/* Reserves the notebook tab for a page that isn't ready yet */
+static GtkWidget *
+notebook_add_placeholder (NMConnectionEditor *editor,
+                          const char *title,
+                          gpointer order)
+{
+	GtkWidget *placeholder;
+
+	placeholder = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+	gtk_widget_show (placeholder);
+	notebook_insert_ordered (editor, placeholder, title, order);
+	return placeholder;
+}
+
+static void
+placeholder_clear (GtkWidget *placeholder)
+{
+	GList *children, *iter;
+
+	children = gtk_container_get_children (GTK_CONTAINER (placeholder));
+	for (iter = children; iter; iter = iter->next)
+		gtk_widget_destroy (GTK_WIDGET (iter->data));
+	g_list_free (children);
+}
+
+/* The rest of the editor is already in use; only this page is lost. It
+ * stays on the secrets list, which keeps the connection from being saved
+ * without its secrets. */
+static void
+page_secrets_failed (NMConnectionEditor *editor, CEPage *page, GError *error)
+{
+	GtkWidget *placeholder, *label;
+	gs_free char *text = NULL;
+
+	g_warning ("Couldn't initialize the %s page: %s", ce_page_get_title (page), error->message);
+
+	placeholder = g_object_get_data (G_OBJECT (page), PLACEHOLDER_TAG);
+	placeholder_clear (placeholder);
+
+	text = g_strdup_printf (_("Could not retrieve the secrets for this page: %s"), error->message);
+	label = gtk_label_new (text);
+	gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+	gtk_box_pack_start (GTK_BOX (placeholder), label, TRUE, TRUE, 0);
+	gtk_widget_show (label);
+
+	connection_editor_validate (editor);
+}
+
+static void
+page_initialized (CEPage *page, GError *error, gpointer user_data)
+{
+	NMConnectionEditor *editor = NM_CONNECTION_EDITOR (user_data);
+	GtkWidget *widget, *parent, *placeholder;
+
+	if (error) {
+		if (editor->init_run && g_slist_find (editor->secrets_pages, page))
+			page_secrets_failed (editor, page, error);
+		else
+			editor_init_failed (editor, error);
+		return;
+	}
+
+	/* Add the page to the UI */
+	widget = ce_page_get_page (page);
+	parent = gtk_widget_get_parent (widget);
+	if (parent)
+		gtk_container_remove (GTK_CONTAINER (parent), widget);
+
+	placeholder = g_object_get_data (G_OBJECT (page), PLACEHOLDER_TAG);
+	if (placeholder) {
+		/* The page's tab is already there; replace whatever it showed meanwhile */
+		placeholder_clear (placeholder);
+		gtk_box_pack_start (GTK_BOX (placeholder), widget, TRUE, TRUE, 0);
+	} else {
+		notebook_insert_ordered (editor,
+		                         widget,
+		                         ce_page_get_title (page),
+		                         g_object_get_data (G_OBJECT (page), ORDER_TAG));
+	}
 
 	if (CE_IS_PAGE_VPN (page) && ce_page_vpn_can_export (CE_PAGE_VPN (page)))
 		gtk_widget_show (editor->export_button);
 
-	/* Move the page from the initializing list to the main page list */
+	/* Move the page from the initializing or secrets list to the main page list */
 	editor->initializing_pages = g_slist_remove (editor->initializing_pages, page);
+	editor->secrets_pages = g_slist_remove (editor->secrets_pages, page);
 	editor->pages = g_slist_append (editor->pages, page);
 
+	if (placeholder) {
+		inter_page_replay (editor, page);
+		connection_editor_validate (editor);
+	}
+
 	recheck_initialization (editor);
 }
 
@@ -791,8 +966,6 @@ page_new_editor (CEPage *page, NMConnectionEditor *new_editor, gpointer user_dat
 	g_signal_emit (self, editor_signals[NEW_EDITOR], 0, new_editor);
 }
 
-static void request_secrets (GetSecretsInfo *info);
-
 static void
 get_secrets_cb (GObject *object,
                 GAsyncResult *result,
@@ -804,40 +977,26 @@ get_secrets_cb (GObject *object,
 	GVariant *secrets;
 	GError *error = NULL;
 
-	if (info->canceled) {
+	secrets = nm_remote_connection_get_secrets_finish (connection, result, &error);
+	if (g_cancellable_is_cancelled (info->cancellable)) {
+		g_clear_error (&error);
+		g_clear_pointer (&secrets, g_variant_unref);
 		get_secrets_info_free (info);
 		return;
 	}
 
-	secrets = nm_remote_connection_get_secrets_finish (connection, result, &error);
-
 	self = info->self;
+	self->secrets_calls = g_slist_remove (self->secrets_calls, info);
 
-	/* Complete this secrets request; completion can actually dispose of the
-	 * dialog if there was an error.
-	 */
-	self->secrets_call = NULL;
+	g_debug ("Secrets for the %s page (setting '%s') arrived after %.1f ms",
+	         ce_page_get_title (info->page),
+	         info->setting_name,
+	         (g_get_monotonic_time () - info->start_time) / 1000.0);
+
+	/* Complete this secrets request; the page then moves to the page list */
 	ce_page_complete_init (info->page, info->setting_name, secrets, error);
+	g_clear_pointer (&secrets, g_variant_unref);
 	get_secrets_info_free (info);
-
-	/* Kick off the next secrets request if there is one queued; if the dialog
-	 * was disposed of by the completion above we don't need to do anything.
-	 */
-	if (!self->disposed && self->pending_secrets_calls) {
-		self->secrets_call = g_slist_nth_data (self->pending_secrets_calls, 0);
-		self->pending_secrets_calls = g_slist_remove (self->pending_secrets_calls, self->secrets_call);
-
-		request_secrets (self->secrets_call);
-	}
-}
-
-static void
-request_secrets (GetSecretsInfo *info)
-{
-	g_return_if_fail (info != NULL);
-
-	nm_remote_connection_get_secrets_async (NM_REMOTE_CONNECTION (info->self->orig_connection),
-	                                        info->setting_name, NULL, get_secrets_cb, info);
 }
 
 static void
@@ -846,47 +1005,82 @@ get_secrets_for_page (NMConnectionEditor *self,
                       const char *setting_name)
 {
 	GetSecretsInfo *info;
+	GtkWidget *placeholder, *spinner;
 
 	info = g_malloc0 (sizeof (GetSecretsInfo));
 	info->self = self;
-	info->page = page;
 	info->setting_name = g_strdup (setting_name);
+	info->cancellable = g_cancellable_new ();
+	info->start_time = g_get_monotonic_time ();
 
-	/* PolicyKit doesn't queue up authorization requests internally.  Instead,
-	 * if there's a pending authorization request, subsequent requests for that
-	 * same authorization will return NotAuthorized+Challenge.  That's pretty
-	 * inconvenient and it would be a lot nicer if PK just queued up subsequent
-	 * authorization requests and executed them when the first one was finished.
-	 * But it since it doesn't do that, we have to serialize the authorization
-	 * requests ourselves to get the right authorization result.
+	/* The page doesn't hold up the rest of the editor while it waits for
+	 * its secrets.
 	 */
-	/* NOTE: PolicyKit-gnome 0.95 now serializes auth requests as of this commit:
-	 * http://git.gnome.org/cgit/PolicyKit-gnome/commit/?id=f32cb7faa7197b9db55b569677732742c3c7fdc1
+	self->initializing_pages = g_slist_remove (self->initializing_pages, page);
+	self->secrets_pages = g_slist_prepend (self->secrets_pages, page);
+	info->page = g_object_ref (page);
+
+	placeholder = g_object_get_data (G_OBJECT (page), PLACEHOLDER_TAG);
+	if (!placeholder) {
+		placeholder = notebook_add_placeholder (self,
+		                                        ce_page_get_title (page),
+		                                        g_object_get_data (G_OBJECT (page), ORDER_TAG));
+		g_object_set_data (G_OBJECT (page), PLACEHOLDER_TAG, placeholder);
+	}
+
+	spinner = gtk_spinner_new ();
+	gtk_widget_set_halign (spinner, GTK_ALIGN_CENTER);
+	gtk_widget_set_valign (spinner, GTK_ALIGN_CENTER);
+	gtk_box_pack_start (GTK_BOX (placeholder), spinner, TRUE, TRUE, 0);
+	gtk_spinner_start (GTK_SPINNER (spinner));
+	gtk_widget_show (spinner);
+
+	/* Requests for different settings go out concurrently; PolicyKit
+	 * serializes the authorization requests itself these days.
 	 */
+	self->secrets_calls = g_slist_append (self->secrets_calls, info);
+	nm_remote_connection_get_secrets_async (NM_REMOTE_CONNECTION (self->orig_connection),
+	                                        setting_name,
+	                                        info->cancellable,
+	                                        get_secrets_cb,
+	                                        info);
+}
 
-	/* If there's already an in-progress call, queue up the new one */
-	if (self->secrets_call)
-		self->pending_secrets_calls = g_slist_append (self->pending_secrets_calls, info);
-	else {
-		/* Request secrets for this page */
-		self->secrets_call = info;
-		request_secrets (info);
+static void
+page_start_init (NMConnectionEditor *editor, CEPage *page)
+{
+	const char *setting_name = g_object_get_data (G_OBJECT (page), SECRETS_TAG);
+
+	if (!setting_name) {
+		/* page doesn't need any secrets */
+		ce_page_complete_init (page, NULL, NULL, NULL);
+	} else if (!NM_IS_REMOTE_CONNECTION (editor->orig_connection)) {
+		/* We want to get secrets using ->orig_connection, since that's the
+		 * remote connection which can actually respond to secrets requests.
+		 * ->connection is a plain NMConnection copy of ->orig_connection
+		 * which is what gets changed when users modify anything.  But when
+		 * creating or importing, ->orig_connection will be an NMConnection
+		 * since the new connection hasn't been added to NetworkManager yet.
+		 * So basically, skip requesting secrets if the connection can't
+		 * handle a secrets request.
+		 */
+		ce_page_complete_init (page, setting_name, NULL, NULL);
+	} else {
+		/* Page wants secrets, get them */
+		get_secrets_for_page (editor, page, setting_name);
 	}
+	g_object_set_data (G_OBJECT (page), SECRETS_TAG, NULL);
 }
 
-static gboolean
-add_page (NMConnectionEditor *editor,
-          CEPageNewFunc func,
-          NMConnection *connection,
-          GError **error)
+static CEPage *
+construct_page (NMConnectionEditor *editor,
+                CEPageNewFunc func,
+                NMConnection *connection,
+                GError **error)
 {
 	CEPage *page;
 	const char *secrets_setting_name = NULL;
 
-	g_return_val_if_fail (editor != NULL, FALSE);
-	g_return_val_if_fail (func != NULL, FALSE);
-	g_return_val_if_fail (connection != NULL, FALSE);
-
 	page = (*func) (editor, connection, GTK_WINDOW (editor->window), editor->client,
 	                &secrets_setting_name, error);
 	if (page) {
@@ -894,18 +1088,124 @@ add_page (NMConnectionEditor *editor,
 		                        SECRETS_TAG,
 		                        g_strdup (secrets_setting_name),
 		                        g_free);
-		g_object_set_data (G_OBJECT (page),
-		                   ORDER_TAG,
-		                   GINT_TO_POINTER (g_slist_length (editor->initializing_pages)));
 
 		editor->initializing_pages = g_slist_append (editor->initializing_pages, page);
 		g_signal_connect (page, CE_PAGE_CHANGED, G_CALLBACK (page_changed), editor);
 		g_signal_connect (page, CE_PAGE_INITIALIZED, G_CALLBACK (page_initialized), editor);
 		g_signal_connect (page, CE_PAGE_NEW_EDITOR, G_CALLBACK (page_new_editor), editor);
 	}
+	return page;
+}
+
+static int
+next_page_order (NMConnectionEditor *editor)
+{
+	return g_slist_length (editor->initializing_pages) + g_slist_length (editor->lazy_pages);
+}
+
+static gboolean
+add_page (NMConnectionEditor *editor,
+          CEPageNewFunc func,
+          NMConnection *connection,
+          GError **error)
+{
+	CEPage *page;
+	int order;
+
+	g_return_val_if_fail (editor != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (connection != NULL, FALSE);
+
+	order = next_page_order (editor);
+	page = construct_page (editor, func, connection, error);
+	if (page)
+		g_object_set_data (G_OBJECT (page), ORDER_TAG, GINT_TO_POINTER (order));
 	return !!page;
 }
 
+/* Adds a page that doesn't request secrets, deferring its construction
+ * until its tab is first shown.  Until then the page's settings are
+ * left untouched in the connection.
+ */
+static gboolean
+add_lazy_page (NMConnectionEditor *editor,
+               CEPageNewFunc func,
+               GType page_type,
+               GError **error)
+{
+	GtkWidget *placeholder;
+	gboolean shown_first;
+	int order;
+
+	g_return_val_if_fail (editor != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+
+	order = next_page_order (editor);
+	shown_first = (order == FIRST_SHOWN_PAGE);
+
+	/* Pages fill in defaults for new and imported connections, so build
+	 * them all right away. The page shown first is needed right away too.
+	 */
+	if (editor->is_new_connection || shown_first)
+		return add_page (editor, func, editor->connection, error);
+
+	placeholder = notebook_add_placeholder (editor,
+	                                        ce_page_type_get_title (page_type),
+	                                        GINT_TO_POINTER (order));
+	g_object_set_data (G_OBJECT (placeholder), LAZY_TAG, (gpointer) func);
+
+	editor->lazy_pages = g_slist_append (editor->lazy_pages, placeholder);
+	return TRUE;
+}
+
+static void
+build_lazy_page (NMConnectionEditor *editor, GtkWidget *placeholder)
+{
+	CEPageNewFunc func;
+	CEPage *page;
+	GError *error = NULL;
+
+	func = (CEPageNewFunc) g_object_get_data (G_OBJECT (placeholder), LAZY_TAG);
+	if (!func)
+		return;
+
+	g_object_set_data (G_OBJECT (placeholder), LAZY_TAG, NULL);
+	editor->lazy_pages = g_slist_remove (editor->lazy_pages, placeholder);
+
+	page = construct_page (editor, func, editor->connection, &error);
+	if (!page) {
+		editor_init_failed (editor, error);
+		g_clear_error (&error);
+		return;
+	}
+
+	g_object_set_data (G_OBJECT (page), ORDER_TAG,
+	                   g_object_get_data (G_OBJECT (placeholder), ORDER_TAG));
+	g_object_set_data (G_OBJECT (page), PLACEHOLDER_TAG, placeholder);
+	page_start_init (editor, page);
+}
+
+static void
+build_lazy_pages (NMConnectionEditor *editor)
+{
+	g_object_ref (editor);
+	while (editor->lazy_pages && !editor->disposed)
+		build_lazy_page (editor, editor->lazy_pages->data);
+	g_object_unref (editor);
+}
+
+static void
+notebook_switch_page_cb (GtkNotebook *notebook,
+                         GtkWidget *child,
+                         guint page_num,
+                         gpointer user_data)
+{
+	NMConnectionEditor *editor = NM_CONNECTION_EDITOR (user_data);
+
+	if (!editor->disposed)
+		build_lazy_page (editor, child);
+}
+
 void
 nm_connection_editor_add_unsupported_property (NMConnectionEditor *editor, const char *name)
 {
@@ -954,6 +1254,7 @@ nm_connection_editor_set_connection (NMConnectionEditor *editor,
 	const char *slave_type;
 	gboolean success = FALSE;
 	GSList *iter, *copy;
+	GtkWidget *notebook;
 
 	g_return_val_if_fail (NM_IS_CONNECTION_EDITOR (editor), FALSE);
 	g_return_val_if_fail (NM_IS_CONNECTION (orig_connection), FALSE);
@@ -974,14 +1275,14 @@ nm_connection_editor_set_connection (NMConnectionEditor *editor,
 	g_assert (s_con);
 
 	connection_type = nm_setting_connection_get_connection_type (s_con);
-	if (!add_page (editor, ce_page_general_new, editor->connection, error))
+	if (!add_lazy_page (editor, ce_page_general_new, CE_TYPE_PAGE_GENERAL, error))
 		goto out;
 	if (!strcmp (connection_type, NM_SETTING_WIRED_SETTING_NAME)) {
 		if (!add_page (editor, ce_page_ethernet_new, editor->connection, error))
 			goto out;
 		if (!add_page (editor, ce_page_8021x_security_new, editor->connection, error))
 			goto out;
-		if (!add_page (editor, ce_page_dcb_new, editor->connection, error))
+		if (!add_lazy_page (editor, ce_page_dcb_new, CE_TYPE_PAGE_DCB, error))
 			goto out;
 	} else if (!strcmp (connection_type, NM_SETTING_WIRELESS_SETTING_NAME)) {
 		if (!add_page (editor, ce_page_wifi_new, editor->connection, error))
@@ -1047,53 +1348,35 @@ nm_connection_editor_set_connection (NMConnectionEditor *editor,
 
 	slave_type = nm_setting_connection_get_slave_type (s_con);
 	if (!g_strcmp0 (slave_type, NM_SETTING_TEAM_SETTING_NAME)) {
-		if (!add_page (editor, ce_page_team_port_new, editor->connection, error))
+		if (!add_lazy_page (editor, ce_page_team_port_new, CE_TYPE_PAGE_TEAM_PORT, error))
 			goto out;
 	} else if (!g_strcmp0 (slave_type, NM_SETTING_BRIDGE_SETTING_NAME)) {
-		if (!add_page (editor, ce_page_bridge_port_new, editor->connection, error))
+		if (!add_lazy_page (editor, ce_page_bridge_port_new, CE_TYPE_PAGE_BRIDGE_PORT, error))
 			goto out;
 	}
 
 	if (   nm_connection_get_setting_proxy (editor->connection)
-	    && !add_page (editor, ce_page_proxy_new, editor->connection, error))
+	    && !add_lazy_page (editor, ce_page_proxy_new, CE_TYPE_PAGE_PROXY, error))
 		goto out;
 	if (   nm_connection_get_setting_ip4_config (editor->connection)
-	    && !add_page (editor, ce_page_ip4_new, editor->connection, error))
+	    && !add_lazy_page (editor, ce_page_ip4_new, CE_TYPE_PAGE_IP4, error))
 		goto out;
 	if (   nm_connection_get_setting_ip6_config (editor->connection)
-	    && !add_page (editor, ce_page_ip6_new, editor->connection, error))
+	    && !add_lazy_page (editor, ce_page_ip6_new, CE_TYPE_PAGE_IP6, error))
 		goto out;
 
+	/* Deferred pages get built when their tab is selected */
+	notebook = GTK_WIDGET (gtk_builder_get_object (editor->builder, "notebook"));
+	g_signal_connect (notebook, "switch-page", G_CALLBACK (notebook_switch_page_cb), editor);
+
 	/* After all pages are created, then kick off secrets requests that any
 	 * the pages may need to make; if they don't need any secrets, then let
 	 * them finish initialization.  The list might get modified during the loop
 	 * which is why copy the list here.
 	 */
 	copy = g_slist_copy (editor->initializing_pages);
-	for (iter = copy; iter; iter = g_slist_next (iter)) {
-		CEPage *page = CE_PAGE (iter->data);
-		const char *setting_name = g_object_get_data (G_OBJECT (page), SECRETS_TAG);
-
-		if (!setting_name) {
-			/* page doesn't need any secrets */
-			ce_page_complete_init (page, NULL, NULL, NULL);
-		} else if (!NM_IS_REMOTE_CONNECTION (editor->orig_connection)) {
-			/* We want to get secrets using ->orig_connection, since that's the
-			 * remote connection which can actually respond to secrets requests.
-			 * ->connection is a plain NMConnection copy of ->orig_connection
-			 * which is what gets changed when users modify anything.  But when
-			 * creating or importing, ->orig_connection will be an NMConnection
-			 * since the new connection hasn't been added to NetworkManager yet.
-			 * So basically, skip requesting secrets if the connection can't
-			 * handle a secrets request.
-			 */
-			ce_page_complete_init (page, setting_name, NULL, NULL);
-		} else {
-			/* Page wants secrets, get them */
-			get_secrets_for_page (editor, page, setting_name);
-		}
-		g_object_set_data (G_OBJECT (page), SECRETS_TAG, NULL);
-	}
+	for (iter = copy; iter; iter = g_slist_next (iter))
+		page_start_init (editor, CE_PAGE (iter->data));
 	g_slist_free (copy);
 
 	/* set the UI */
@@ -1381,7 +1664,21 @@ nm_connection_editor_warning (GtkWindow *parent, const char *heading, const char
 void
 nm_connection_editor_inter_page_set_value (NMConnectionEditor *editor, InterPageChangeType type, gpointer value)
 {
+	gpointer last;
+	gboolean changed;
+
+	changed =    g_hash_table_lookup_extended (editor->inter_page_last, GUINT_TO_POINTER (type), NULL, &last)
+	          && last != value;
+
 	g_hash_table_insert (editor->inter_page_hash, GUINT_TO_POINTER (type), value);
+	g_hash_table_insert (editor->inter_page_last, GUINT_TO_POINTER (type), value);
+
+	/* Pages that were not shown yet may need to adjust their settings too.
+	 * Pages also report values they didn't change, e.g. while they
+	 * initialize; those leave the deferred pages alone.
+	 */
+	if (changed && editor->init_run)
+		build_lazy_pages (editor);
 }
 
 gboolean
@@ -36,14 +36,16 @@ typedef struct {
 	NMConnection *orig_connection;
 	gboolean is_new_connection;
 
-	GetSecretsInfo *secrets_call;
-	GSList *pending_secrets_calls;
+	GSList *secrets_calls;
 
 	GtkWidget *all_checkbutton;
 	NMClientPermissionResult can_modify;
 
 	GSList *initializing_pages;
 	GSList *pages;
+	GSList *lazy_pages;
+	/* Pages waiting for their secrets, or that failed to get them */
+	GSList *secrets_pages;
 	GtkBuilder *builder;
 	GtkWidget *window;
 	GtkWidget *ok_button;
@@ -60,7 +62,12 @@ typedef struct {
 
 	char *last_validation_error;
 
+	/* The keys the editor is indexed with for nm_connection_editor_get_master() */
+	char *indexed_uuid;
+	char *indexed_iface;
+
 	GHashTable *inter_page_hash;
+	GHashTable *inter_page_last;
 	GSList *unsupported_properties;
 } NMConnectionEditor;
 
@@ -42,6 +42,26 @@ struct _NMConnectionListPrivate {
 	GtkTreeSortable *sortable;
 	GType displayed_type;
 
+	/* NMRemoteConnection -> ConnectionRow */
+	GHashTable *rows;
+
+	/* Indexes for resolving a port's master: UUID -> ConnectionRow, and
+	 * interface name -> number of connections using it. */
+	GHashTable *uuids;
+	GHashTable *ifaces;
+
+	/* Casefolded search entry text, and the number of connections
+	 * matching it for each type node (indexed by COL_ORDER). */
+	char *search_key;
+	guint *type_matches;
+
+	/* Refilter for the changes made in this main loop iteration, and the
+	 * type nodes to expand once it's done (keyed by COL_ORDER). */
+	UtilsBatch *refilter;
+	GHashTable *expand_types;
+
+	guint last_used_refresh_id;
+
 	NMClient *client;
 
 	gboolean populated;
@@ -55,13 +75,91 @@ G_DEFINE_TYPE_WITH_CODE (NMConnectionList, nm_connection_list, GTK_TYPE_APPLICAT
                          G_ADD_PRIVATE (NMConnectionList))
 
 #define COL_ID         0
-#define COL_LAST_USED  1
-#define COL_TIMESTAMP  2
-#define COL_CONNECTION 3
-#define COL_GTYPE0     4
-#define COL_GTYPE1     5
-#define COL_GTYPE2     6
-#define COL_ORDER      7
+#define COL_TIMESTAMP  1
+#define COL_CONNECTION 2
+#define COL_GTYPE0     3
+#define COL_GTYPE1     4
+#define COL_GTYPE2     5
+#define COL_ORDER      6
+
+typedef struct {
+	/* The iter stays valid as long as the row exists, since
+	 * GtkTreeStore iters persist. */
+	GtkTreeIter iter;
+	int type_order;
+
+	/* Casefolded connection ID, and whether it matches the search */
+	char *search_id;
+	gboolean matches;
+
+	/* The keys the row is indexed with */
+	char *uuid;
+	char *iface;
+
+	/* The "Last Used" label bucket the row was last shown with */
+	guint64 timestamp;
+	guint last_used_bucket;
+} ConnectionRow;
+
+static void
+connection_row_free (gpointer data)
+{
+	ConnectionRow *row = data;
+
+	g_free (row->search_id);
+	g_free (row->uuid);
+	g_free (row->iface);
+	g_slice_free (ConnectionRow, row);
+}
+
+static void
+connection_row_update_match (NMConnectionListPrivate *priv, ConnectionRow *row)
+{
+	gboolean matches;
+
+	matches = strstr (row->search_id, priv->search_key) != NULL;
+	if (matches == row->matches)
+		return;
+
+	row->matches = matches;
+	if (matches)
+		priv->type_matches[row->type_order]++;
+	else
+		priv->type_matches[row->type_order]--;
+}
+
+static void
+connection_row_set_id (NMConnectionListPrivate *priv, ConnectionRow *row, const char *id)
+{
+	g_free (row->search_id);
+	row->search_id = g_utf8_casefold (id, -1);
+	connection_row_update_match (priv, row);
+}
+
+static void
+connection_row_set_iface (NMConnectionListPrivate *priv, ConnectionRow *row, const char *iface)
+{
+	guint count;
+
+	if (!g_strcmp0 (row->iface, iface))
+		return;
+
+	if (row->iface) {
+		count = GPOINTER_TO_UINT (g_hash_table_lookup (priv->ifaces, row->iface));
+		if (count > 1)
+			g_hash_table_insert (priv->ifaces, g_strdup (row->iface), GUINT_TO_POINTER (count - 1));
+		else
+			g_hash_table_remove (priv->ifaces, row->iface);
+	}
+
+	g_free (row->iface);
+	row->iface = g_strdup (iface);
+
+	if (iface) {
+		count = GPOINTER_TO_UINT (g_hash_table_lookup (priv->ifaces, iface));
+		g_hash_table_insert (priv->ifaces, g_strdup (iface), GUINT_TO_POINTER (count + 1));
+	}
+}
 
 static NMRemoteConnection *
 get_active_connection (GtkTreeView *treeview)
@@ -96,103 +194,227 @@ get_iter_for_connection (NMConnectionList *list,
                          NMRemoteConnection *connection,
                          GtkTreeIter *iter)
 {
-	GtkTreeIter types_iter;
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (list);
+	ConnectionRow *row;
 
-	if (!gtk_tree_model_get_iter_first (priv->model, &types_iter))
+	row = g_hash_table_lookup (priv->rows, connection);
+	if (!row)
 		return FALSE;
 
-	do {
-		if (!gtk_tree_model_iter_children (priv->model, iter, &types_iter))
-			continue;
+	*iter = row->iter;
+	return TRUE;
+}
 
-		do {
-			NMRemoteConnection *candidate = NULL;
+static void
+refilter_cb (gpointer user_data)
+{
+	NMConnectionList *list = user_data;
+	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (list);
+	GHashTableIter hiter;
+	GtkTreeIter *type_iter;
 
-			gtk_tree_model_get (priv->model, iter,
-			                    COL_CONNECTION, &candidate,
-			                    -1);
-			if (candidate == connection) {
-				g_object_unref (candidate);
-				return TRUE;
-			}
-			g_object_unref (candidate);
-		} while (gtk_tree_model_iter_next (priv->model, iter));
-	} while (gtk_tree_model_iter_next (priv->model, &types_iter));
+	gtk_tree_model_filter_refilter (priv->filter);
 
-	return FALSE;
+	/* Type nodes only become visible with the refilter, so they can't be
+	 * expanded before it. */
+	g_hash_table_iter_init (&hiter, priv->expand_types);
+	while (g_hash_table_iter_next (&hiter, NULL, (gpointer *) &type_iter)) {
+		GtkTreePath *path, *filtered_path;
+
+		path = gtk_tree_model_get_path (priv->model, type_iter);
+		filtered_path = gtk_tree_model_filter_convert_child_path_to_path (priv->filter, path);
+		if (filtered_path) {
+			gtk_tree_view_expand_row (priv->connection_list, filtered_path, FALSE);
+			gtk_tree_path_free (filtered_path);
+		}
+		gtk_tree_path_free (path);
+	}
+	g_hash_table_remove_all (priv->expand_types);
 }
 
-static char *
-format_last_used (guint64 timestamp)
+/* Rows added, changed or removed within one main loop iteration (such as
+ * when NetworkManager reloads all connections) share a single refilter.
+ */
+static void
+schedule_refilter (NMConnectionList *list)
 {
-	GTimeVal now_tv;
-	GDate *now, *last;
-	char *last_used = NULL;
+	utils_batch_schedule (NM_CONNECTION_LIST_GET_PRIVATE (list)->refilter);
+}
 
-	if (!timestamp)
-		return g_strdup (_("never"));
+static void
+refilter_now (NMConnectionList *list)
+{
+	utils_batch_run_now (NM_CONNECTION_LIST_GET_PRIVATE (list)->refilter);
+}
 
-	g_get_current_time (&now_tv);
-	now = g_date_new ();
-	g_date_set_time_val (now, &now_tv);
+/* The "Last Used" labels only depend on the unit of the elapsed time and
+ * its count.  These buckets are cheap to compute, and each bucket's label
+ * is only formatted once.
+ */
+typedef enum {
+	LAST_USED_NEVER,
+	LAST_USED_NOW,
+	LAST_USED_MINUTES,
+	LAST_USED_HOURS,
+	LAST_USED_TODAY,
+	LAST_USED_DAYS,
+	LAST_USED_MONTHS,
+	LAST_USED_YEARS,
+} LastUsedUnit;
+
+#define LAST_USED_BUCKET(unit, n)   (((guint) (n) << 3) | (unit))
+
+static guint
+last_used_bucket (guint64 timestamp, time_t now)
+{
+	GDate now_date, last_date;
+	guint days, months, years;
 
-	last = g_date_new ();
-	g_date_set_time_t (last, (time_t) timestamp);
+	if (!timestamp)
+		return LAST_USED_BUCKET (LAST_USED_NEVER, 0);
 
 	/* timestamp is now or in the future */
-	if (now_tv.tv_sec <= timestamp) {
-		last_used = g_strdup (_("now"));
-		goto out;
-	}
+	if (now <= timestamp)
+		return LAST_USED_BUCKET (LAST_USED_NOW, 0);
 
-	if (g_date_compare (now, last) <= 0) {
+	g_date_clear (&now_date, 1);
+	g_date_set_time_t (&now_date, now);
+	g_date_clear (&last_date, 1);
+	g_date_set_time_t (&last_date, (time_t) timestamp);
+
+	if (g_date_compare (&now_date, &last_date) <= 0) {
 		guint minutes, hours;
 
 		/* Same day */
 
-		minutes = (now_tv.tv_sec - timestamp) / 60;
-		if (minutes == 0) {
-			last_used = g_strdup (_("now"));
-			goto out;
-		}
+		minutes = (now - timestamp) / 60;
+		if (minutes == 0)
+			return LAST_USED_BUCKET (LAST_USED_NOW, 0);
 
-		hours = (now_tv.tv_sec - timestamp) / 3600;
+		hours = (now - timestamp) / 3600;
 		if (hours == 0) {
 			/* less than an hour ago */
-			last_used = g_strdup_printf (ngettext ("%d minute ago", "%d minutes ago", minutes), minutes);
-			goto out;
+			return LAST_USED_BUCKET (LAST_USED_MINUTES, minutes);
 		}
 
-		last_used = g_strdup_printf (ngettext ("%d hour ago", "%d hours ago", hours), hours);
-	} else {
-		guint days, months, years;
+		return LAST_USED_BUCKET (LAST_USED_HOURS, hours);
+	}
 
-		days = g_date_get_julian (now) - g_date_get_julian (last);
-		if (days == 0) {
-			last_used = g_strdup ("today");
-			goto out;
-		}
+	days = g_date_get_julian (&now_date) - g_date_get_julian (&last_date);
+	if (days == 0)
+		return LAST_USED_BUCKET (LAST_USED_TODAY, 0);
 
-		months = days / 30;
-		if (months == 0) {
-			last_used = g_strdup_printf (ngettext ("%d day ago", "%d days ago", days), days);
-			goto out;
-		}
+	months = days / 30;
+	if (months == 0)
+		return LAST_USED_BUCKET (LAST_USED_DAYS, days);
 
-		years = days / 365;
-		if (years == 0) {
-			last_used = g_strdup_printf (ngettext ("%d month ago", "%d months ago", months), months);
-			goto out;
-		}
+	years = days / 365;
+	if (years == 0)
+		return LAST_USED_BUCKET (LAST_USED_MONTHS, months);
 
-		last_used = g_strdup_printf (ngettext ("%d year ago", "%d years ago", years), years);
+	return LAST_USED_BUCKET (LAST_USED_YEARS, years);
+}
+
+static const char *
+last_used_label (guint bucket)
+{
+	static GHashTable *labels = NULL;
+	guint n = bucket >> 3;
+	char *label;
+
+	if (G_UNLIKELY (!labels))
+		labels = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
+	label = g_hash_table_lookup (labels, GUINT_TO_POINTER (bucket));
+	if (label)
+		return label;
+
+	switch ((LastUsedUnit) (bucket & 0x7)) {
+	case LAST_USED_NEVER:
+		label = g_strdup (_("never"));
+		break;
+	case LAST_USED_NOW:
+		label = g_strdup (_("now"));
+		break;
+	case LAST_USED_MINUTES:
+		label = g_strdup_printf (ngettext ("%d minute ago", "%d minutes ago", n), n);
+		break;
+	case LAST_USED_HOURS:
+		label = g_strdup_printf (ngettext ("%d hour ago", "%d hours ago", n), n);
+		break;
+	case LAST_USED_TODAY:
+		label = g_strdup ("today");
+		break;
+	case LAST_USED_DAYS:
+		label = g_strdup_printf (ngettext ("%d day ago", "%d days ago", n), n);
+		break;
+	case LAST_USED_MONTHS:
+		label = g_strdup_printf (ngettext ("%d month ago", "%d months ago", n), n);
+		break;
+	case LAST_USED_YEARS:
+	default:
+		label = g_strdup_printf (ngettext ("%d year ago", "%d years ago", n), n);
+		break;
 	}
 
-out:
-	g_date_free (now);
-	g_date_free (last);
-	return last_used;
+	g_hash_table_insert (labels, GUINT_TO_POINTER (bucket), label);
+	return label;
+}
+
+static void
+last_used_cell_data_func (GtkTreeViewColumn *column,
+                          GtkCellRenderer *cell,
+                          GtkTreeModel *model,
+                          GtkTreeIter *iter,
+                          gpointer user_data)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	guint64 timestamp;
+
+	gtk_tree_model_get (model, iter,
+	                    COL_CONNECTION, &connection,
+	                    COL_TIMESTAMP, &timestamp,
+	                    -1);
+
+	/* Type nodes have no last used time */
+	g_object_set (cell,
+	              "text", connection ? last_used_label (last_used_bucket (timestamp, time (NULL))) : NULL,
+	              NULL);
+}
+
+static void
+connection_row_set_timestamp (ConnectionRow *row, guint64 timestamp)
+{
+	row->timestamp = timestamp;
+	row->last_used_bucket = last_used_bucket (timestamp, time (NULL));
+}
+
+/* Redraws the "Last Used" cells of the rows whose label has changed */
+static gboolean
+last_used_refresh_cb (gpointer user_data)
+{
+	NMConnectionList *list = user_data;
+	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (list);
+	GHashTableIter hiter;
+	ConnectionRow *row;
+	time_t now = time (NULL);
+	guint bucket;
+
+	g_hash_table_iter_init (&hiter, priv->rows);
+	while (g_hash_table_iter_next (&hiter, NULL, (gpointer *) &row)) {
+		GtkTreePath *path;
+
+		bucket = last_used_bucket (row->timestamp, now);
+		if (bucket == row->last_used_bucket)
+			continue;
+		row->last_used_bucket = bucket;
+
+		path = gtk_tree_model_get_path (priv->model, &row->iter);
+		gtk_tree_model_row_changed (priv->model, path, &row->iter);
+		gtk_tree_path_free (path);
+	}
+
+	return G_SOURCE_CONTINUE;
 }
 
 static void
@@ -202,23 +424,28 @@ update_connection_row (NMConnectionList *self,
 {
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (self);
 	NMSettingConnection *s_con;
-	char *last_used, *id;
+	ConnectionRow *row;
+	char *id;
 
 	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
 	g_assert (s_con);
 
-	last_used = format_last_used (nm_setting_connection_get_timestamp (s_con));
+	row = g_hash_table_lookup (priv->rows, connection);
+	if (row) {
+		connection_row_set_id (priv, row, nm_setting_connection_get_id (s_con));
+		connection_row_set_timestamp (row, nm_setting_connection_get_timestamp (s_con));
+		connection_row_set_iface (priv, row, nm_connection_get_interface_name (NM_CONNECTION (connection)));
+	}
+
 	id = g_markup_escape_text (nm_setting_connection_get_id (s_con), -1);
 	gtk_tree_store_set (GTK_TREE_STORE (priv->model), iter,
 	                    COL_ID, id,
-	                    COL_LAST_USED, last_used,
 	                    COL_TIMESTAMP, nm_setting_connection_get_timestamp (s_con),
 	                    COL_CONNECTION, connection,
 	                    -1);
-	g_free (last_used);
 	g_free (id);
 
-	gtk_tree_model_filter_refilter (priv->filter);
+	schedule_refilter (self);
 }
 
 static void
@@ -502,8 +729,28 @@ search_changed (GtkSearchEntry *entry, gpointer user_data)
 {
 	NMConnectionList *list = user_data;
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (list);
+	gs_free char *old_key = NULL;
+	gboolean narrower, wider;
+	GHashTableIter hiter;
+	ConnectionRow *row;
+
+	old_key = priv->search_key;
+	priv->search_key = g_utf8_casefold (gtk_entry_get_text (GTK_ENTRY (priv->search_entry)), -1);
+
+	/* Rows matching a query also match any query it contains, and rows
+	 * not matching it don't match any query containing it. */
+	narrower = strstr (priv->search_key, old_key) != NULL;
+	wider = strstr (old_key, priv->search_key) != NULL;
+	if (!narrower || !wider) {
+		g_hash_table_iter_init (&hiter, priv->rows);
+		while (g_hash_table_iter_next (&hiter, NULL, (gpointer *) &row)) {
+			if (row->matches ? wider : narrower)
+				continue;
+			connection_row_update_match (priv, row);
+		}
+	}
 
-	gtk_tree_model_filter_refilter (priv->filter);
+	refilter_now (list);
 	gtk_tree_view_expand_all (priv->connection_list);
 }
 
@@ -520,6 +767,14 @@ dispose (GObject *object)
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (list);
 
 	g_clear_object (&priv->client);
+	g_clear_pointer (&priv->refilter, utils_batch_free);
+	nm_clear_g_source (&priv->last_used_refresh_id);
+	g_clear_pointer (&priv->expand_types, g_hash_table_unref);
+	g_clear_pointer (&priv->uuids, g_hash_table_unref);
+	g_clear_pointer (&priv->ifaces, g_hash_table_unref);
+	g_clear_pointer (&priv->rows, g_hash_table_unref);
+	nm_clear_g_free (&priv->search_key);
+	nm_clear_g_free (&priv->type_matches);
 
 	G_OBJECT_CLASS (nm_connection_list_parent_class)->dispose (object);
 }
@@ -640,32 +895,13 @@ static gboolean
 has_visible_children (NMConnectionList *self, GtkTreeModel *model, GtkTreeIter *parent)
 {
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (self);
-	GtkTreeIter iter;
-	const char *search;
-	char *id = NULL;
+	int order;
 
 	if (!gtk_search_bar_get_search_mode (priv->search_bar))
 		return gtk_tree_model_iter_has_child  (model, parent);
 
-	if (!gtk_tree_model_iter_children (model, &iter, parent))
-		return FALSE;
-
-	search = gtk_entry_get_text (GTK_ENTRY (priv->search_entry));
-	do {
-		gtk_tree_model_get (model, &iter, COL_ID, &id, -1);
-		if (!id) {
-			/* gtk_tree_store_append() inserts an empty row, ignore
-			 * it until it is fully populated. */
-			continue;
-		}
-		if (strcasestr (id, search) != NULL) {
-			g_free (id);
-			return TRUE;
-		}
-		g_free (id);
-	} while (gtk_tree_model_iter_next (model, &iter));
-
-	return FALSE;
+	gtk_tree_model_get (model, parent, COL_ORDER, &order, -1);
+	return priv->type_matches[order] > 0;
 }
 
 static gboolean
@@ -679,10 +915,9 @@ tree_model_visible_func (GtkTreeModel *model,
 	NMSettingConnection *s_con;
 	const char *master;
 	const char *slave_type;
-	gs_free char *id = NULL;
+	ConnectionRow *row;
 
 	gtk_tree_model_get (model, iter,
-	                    COL_ID, &id,
 	                    COL_CONNECTION, &connection,
 	                    -1);
 	if (!connection) {
@@ -690,9 +925,11 @@ tree_model_visible_func (GtkTreeModel *model,
 		return has_visible_children (self, model, iter);
 	}
 
-	if (   gtk_search_bar_get_search_mode (priv->search_bar)
-	    && strcasestr (id, gtk_entry_get_text (GTK_ENTRY (priv->search_entry))) == NULL)
-		return FALSE;
+	if (gtk_search_bar_get_search_mode (priv->search_bar)) {
+		row = g_hash_table_lookup (priv->rows, connection);
+		if (!row || !row->matches)
+			return FALSE;
+	}
 
 	/* A connection node is visible unless it is a slave to a known
 	 * bond or team or bridge.
@@ -711,13 +948,12 @@ tree_model_visible_func (GtkTreeModel *model,
 	    && g_strcmp0 (slave_type, NM_SETTING_BRIDGE_SETTING_NAME) != 0)
 		return TRUE;
 
-	if (nm_client_get_connection_by_uuid (priv->client, master))
+	if (   g_hash_table_contains (priv->uuids, master)
+	    || g_hash_table_contains (priv->ifaces, master))
 		return FALSE;
 	if (nm_connection_editor_get_master (connection))
 		return FALSE;
 
-	/* FIXME: what if master is an interface name */
-
 	return TRUE;
 }
 
@@ -725,18 +961,25 @@ static gboolean
 connection_list_equal (GtkTreeModel *model, gint column, const gchar *key,
                        GtkTreeIter *iter, gpointer user_data)
 {
-	gs_free char *id = NULL;
+	NMConnectionList *self = user_data;
+	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (self);
 	gs_unref_object NMConnection *connection = NULL;
+	gs_free char *search_key = NULL;
+	ConnectionRow *row;
 
 	gtk_tree_model_get (model, iter,
-	                    COL_ID, &id,
 	                    COL_CONNECTION, &connection,
 	                    -1);
 
 	if (!connection)
 		return TRUE;
 
-	return strcasestr (id, key) == NULL;
+	row = g_hash_table_lookup (priv->rows, connection);
+	if (!row)
+		return TRUE;
+
+	search_key = g_utf8_casefold (key, -1);
+	return strstr (row->search_id, search_key) == NULL;
 }
 
 static void
@@ -752,20 +995,27 @@ initialize_treeview (NMConnectionList *self)
 	int i;
 
 	/* Model */
-	priv->model = GTK_TREE_MODEL (gtk_tree_store_new (8, G_TYPE_STRING,
-	                                                     G_TYPE_STRING,
+	priv->model = GTK_TREE_MODEL (gtk_tree_store_new (7, G_TYPE_STRING,
 	                                                     G_TYPE_UINT64,
 	                                                     G_TYPE_OBJECT,
 	                                                     G_TYPE_GTYPE,
 	                                                     G_TYPE_GTYPE,
 	                                                     G_TYPE_GTYPE,
 	                                                     G_TYPE_INT));
+	priv->rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                    NULL, connection_row_free);
+	priv->uuids = g_hash_table_new (g_str_hash, g_str_equal);
+	priv->ifaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->search_key = g_strdup ("");
+	priv->expand_types = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                            NULL, (GDestroyNotify) gtk_tree_iter_free);
 
 	/* Filter */
 	priv->filter = GTK_TREE_MODEL_FILTER (gtk_tree_model_filter_new (priv->model, NULL));
 	gtk_tree_model_filter_set_visible_func (priv->filter,
 	                                        tree_model_visible_func,
 	                                        self, NULL);
+	priv->refilter = utils_batch_new (refilter_cb, self);
 
 	/* Sortable */
 	priv->sortable = GTK_TREE_SORTABLE (gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (priv->filter)));
@@ -777,7 +1027,7 @@ initialize_treeview (NMConnectionList *self)
 	gtk_tree_sortable_set_sort_column_id (priv->sortable, COL_TIMESTAMP, GTK_SORT_ASCENDING);
 
 	gtk_tree_view_set_model (priv->connection_list, GTK_TREE_MODEL (priv->sortable));
-	gtk_tree_view_set_search_equal_func (priv->connection_list, connection_list_equal, NULL, NULL);
+	gtk_tree_view_set_search_equal_func (priv->connection_list, connection_list_equal, self, NULL);
 	gtk_tree_view_set_search_entry (priv->connection_list, priv->search_entry);
 
 	/* Name column */
@@ -797,11 +1047,14 @@ initialize_treeview (NMConnectionList *self)
 	                         NULL);
 	column = gtk_tree_view_column_new_with_attributes (_("Last Used"),
 	                                                   renderer,
-	                                                   "text", COL_LAST_USED,
 	                                                   NULL);
+	gtk_tree_view_column_set_cell_data_func (column, renderer,
+	                                         last_used_cell_data_func,
+	                                         NULL, NULL);
 	gtk_tree_view_column_set_sort_column_id (column, COL_TIMESTAMP);
 	g_signal_connect (column, "clicked", G_CALLBACK (column_header_clicked_cb), GINT_TO_POINTER (COL_TIMESTAMP));
 	gtk_tree_view_append_column (priv->connection_list, column);
+	priv->last_used_refresh_id = g_timeout_add_seconds (60, last_used_refresh_cb, self);
 
 	/* Selection */
 	selection = gtk_tree_view_get_selection (priv->connection_list);
@@ -809,6 +1062,10 @@ initialize_treeview (NMConnectionList *self)
 
 	/* Fill in connection types */
 	types = get_connection_type_list ();
+	i = 0;
+	while (types[i].name)
+		i++;
+	priv->type_matches = g_new0 (guint, i);
 	for (i = 0; types[i].name; i++) {
 
 		tmp = g_markup_escape_text (types[i].name, -1);
@@ -853,12 +1110,21 @@ connection_removed (NMClient *client,
 	NMConnectionList *self = NM_CONNECTION_LIST (user_data);
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (self);
 	GtkTreeIter iter, parent_iter;
-
-	if (get_iter_for_connection (self, connection, &iter)) {
+	ConnectionRow *row;
+
+	row = g_hash_table_lookup (priv->rows, connection);
+	if (row) {
+		iter = row->iter;
+		if (row->matches)
+			priv->type_matches[row->type_order]--;
+		if (row->uuid && g_hash_table_lookup (priv->uuids, row->uuid) == row)
+			g_hash_table_remove (priv->uuids, row->uuid);
+		connection_row_set_iface (priv, row, NULL);
 		gtk_tree_model_iter_parent (priv->model, &parent_iter, &iter);
+		g_hash_table_remove (priv->rows, connection);
 		gtk_tree_store_remove (GTK_TREE_STORE (priv->model), &iter);
 	}
-	gtk_tree_model_filter_refilter (priv->filter);
+	schedule_refilter (self);
 }
 
 static void
@@ -920,28 +1186,43 @@ connection_added (NMClient *client,
 	NMConnectionListPrivate *priv = NM_CONNECTION_LIST_GET_PRIVATE (self);
 	GtkTreeIter parent_iter, iter;
 	NMSettingConnection *s_con;
-	char *last_used, *id;
+	char *id;
 	gboolean expand = TRUE;
+	ConnectionRow *row;
+	int order;
+
+	if (g_hash_table_contains (priv->rows, connection))
+		return;
 
 	if (!get_parent_iter_for_connection (self, connection, &parent_iter))
 		return;
 
 	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
 
-	last_used = format_last_used (nm_setting_connection_get_timestamp (s_con));
-
 	id = g_markup_escape_text (nm_setting_connection_get_id (s_con), -1);
 
-	gtk_tree_store_append (GTK_TREE_STORE (priv->model), &iter, &parent_iter);
-	gtk_tree_store_set (GTK_TREE_STORE (priv->model), &iter,
-	                    COL_ID, id,
-	                    COL_LAST_USED, last_used,
-	                    COL_TIMESTAMP, nm_setting_connection_get_timestamp (s_con),
-	                    COL_CONNECTION, connection,
-	                    -1);
+	gtk_tree_store_insert_with_values (GTK_TREE_STORE (priv->model), &iter, &parent_iter, -1,
+	                                   COL_ID, id,
+	                                   COL_TIMESTAMP, nm_setting_connection_get_timestamp (s_con),
+	                                   COL_CONNECTION, connection,
+	                                   -1);
 
 	g_free (id);
-	g_free (last_used);
+
+	gtk_tree_model_get (priv->model, &parent_iter,
+	                    COL_ORDER, &order,
+	                    -1);
+
+	row = g_slice_new0 (ConnectionRow);
+	row->iter = iter;
+	row->type_order = order;
+	connection_row_set_id (priv, row, nm_setting_connection_get_id (s_con));
+	connection_row_set_timestamp (row, nm_setting_connection_get_timestamp (s_con));
+	connection_row_set_iface (priv, row, nm_connection_get_interface_name (NM_CONNECTION (connection)));
+	row->uuid = g_strdup (nm_connection_get_uuid (NM_CONNECTION (connection)));
+	if (row->uuid)
+		g_hash_table_insert (priv->uuids, row->uuid, row);
+	g_hash_table_insert (priv->rows, connection, row);
 
 	if (priv->displayed_type) {
 		GType added_type0, added_type1, added_type2;
@@ -958,17 +1239,12 @@ connection_added (NMClient *client,
 	}
 
 	if (expand) {
-		GtkTreePath *path, *filtered_path;
-
-		path = gtk_tree_model_get_path (priv->model, &parent_iter);
-		filtered_path = gtk_tree_model_filter_convert_child_path_to_path (priv->filter, path);
-		gtk_tree_view_expand_row (priv->connection_list, filtered_path, FALSE);
-		gtk_tree_path_free (filtered_path);
-		gtk_tree_path_free (path);
+		g_hash_table_insert (priv->expand_types, GINT_TO_POINTER (order),
+		                     gtk_tree_iter_copy (&parent_iter));
 	}
 
 	g_signal_connect (connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed), self);
-	gtk_tree_model_filter_refilter (priv->filter);
+	schedule_refilter (self);
 }
 
 NMConnectionList *
@@ -1144,6 +1420,7 @@ nm_connection_list_present (NMConnectionList *list)
 		all_cons = nm_client_get_connections (priv->client);
 		for (i = 0; i < all_cons->len; i++)
 			connection_added (priv->client, all_cons->pdata[i], list);
+		refilter_now (list);
 		if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->sortable), &iter)) {
 			path = gtk_tree_model_get_path (GTK_TREE_MODEL (priv->sortable), &iter);
 			gtk_tree_view_scroll_to_cell (priv->connection_list,
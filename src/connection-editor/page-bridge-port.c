@@ -85,10 +85,7 @@ ce_page_bridge_port_new (NMConnectionEditor *editor,
 	                                         client,
 	                                         "/org/gnome/nm_connection_editor/ce-page-bridge-port.ui",
 	                                         "BridgePortPage",
-	                                         /* Translators: a "Bridge Port" is a network
-	                                          * device that is part of a bridge.
-	                                          */
-	                                         _("Bridge Port")));
+	                                         NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("Could not load bridge port user interface."));
 		return NULL;
@@ -143,6 +140,11 @@ ce_page_bridge_port_class_init (CEPageBridgePortClass *bridge_port_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageBridgePortPrivate));
 
+	/* Translators: a "Bridge Port" is a network
+	 * device that is part of a bridge.
+	 */
+	parent_class->title = _("Bridge Port");
+
 	/* virtual methods */
 	parent_class->ce_page_validate_v = ce_page_validate_v;
 }
@@ -607,7 +607,7 @@ ce_page_dcb_new (NMConnectionEditor *editor,
 	                                 client,
 	                                 "/org/gnome/nm_connection_editor/ce-page-dcb.ui",
 	                                 "DcbPage",
-	                                 _("DCB")));
+	                                 NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("Could not load DCB user interface."));
 		return NULL;
@@ -776,6 +776,8 @@ ce_page_dcb_class_init (CEPageDcbClass *security_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageDcbPrivate));
 
+	parent_class->title = _("DCB");
+
 	/* virtual methods */
 	object_class->dispose = dispose;
 
@@ -365,7 +365,7 @@ ce_page_general_new (NMConnectionEditor *editor,
 	                                     client,
 	                                     "/org/gnome/nm_connection_editor/ce-page-general.ui",
 	                                     "GeneralPage",
-	                                     _("General")));
+	                                     NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC,
 		                     _("Could not load General user interface."));
@@ -464,6 +464,8 @@ ce_page_general_class_init (CEPageGeneralClass *connection_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageGeneralPrivate));
 
+	parent_class->title = _("General");
+
 	/* virtual methods */
 	object_class->dispose = dispose;
 
@@ -1206,7 +1206,7 @@ ce_page_ip4_new (NMConnectionEditor *editor,
 	                                 client,
 	                                 "/org/gnome/nm_connection_editor/ce-page-ip4.ui",
 	                                 "IP4Page",
-	                                 _("IPv4 Settings")));
+	                                 NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("Could not load IPv4 user interface."));
 		return NULL;
@@ -1557,6 +1557,8 @@ ce_page_ip4_class_init (CEPageIP4Class *ip4_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageIP4Private));
 
+	parent_class->title = _("IPv4 Settings");
+
 	/* virtual methods */
 	parent_class->ce_page_validate_v = ce_page_validate_v;
 	parent_class->inter_page_change = inter_page_change;
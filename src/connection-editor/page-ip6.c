@@ -1208,7 +1208,7 @@ ce_page_ip6_new (NMConnectionEditor *editor,
 	                                 client,
 	                                 "/org/gnome/nm_connection_editor/ce-page-ip6.ui",
 	                                 "IP6Page",
-	                                 _("IPv6 Settings")));
+	                                 NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("Could not load IPv6 user interface."));
 		return NULL;
@@ -1565,6 +1565,8 @@ ce_page_ip6_class_init (CEPageIP6Class *ip6_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageIP6Private));
 
+	parent_class->title = _("IPv6 Settings");
+
 	/* virtual methods */
 	parent_class->ce_page_validate_v = ce_page_validate_v;
 	parent_class->inter_page_change = inter_page_change;
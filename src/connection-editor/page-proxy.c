@@ -195,7 +195,7 @@ ce_page_proxy_new (NMConnectionEditor *editor,
 	                                   client,
 	                                   "/org/gnome/nm_connection_editor/ce-page-proxy.ui",
 	                                   "ProxyPage",
-	                                   _("Proxy")));
+	                                   NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("Could not load proxy user interface."));
 		return NULL;
@@ -295,6 +295,8 @@ ce_page_proxy_class_init (CEPageProxyClass *proxy_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageProxyPrivate));
 
+	parent_class->title = _("Proxy");
+
 	/* virtual methods */
 	parent_class->ce_page_validate_v = ce_page_validate_v;
 }
@@ -632,10 +632,7 @@ ce_page_team_port_new (NMConnectionEditor *editor,
 	                                       client,
 	                                       "/org/gnome/nm_connection_editor/ce-page-team-port.ui",
 	                                       "TeamPortPage",
-	                                       /* Translators: a "Team Port" is a network
-	                                        * device that is part of a team.
-	                                        */
-	                                       _("Team Port")));
+	                                       NULL));
 	if (!self) {
 		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("Could not load team port user interface."));
 		return NULL;
@@ -699,6 +696,11 @@ ce_page_team_port_class_init (CEPageTeamPortClass *team_port_class)
 
 	g_type_class_add_private (object_class, sizeof (CEPageTeamPortPrivate));
 
+	/* Translators: a "Team Port" is a network
+	 * device that is part of a team.
+	 */
+	parent_class->title = _("Team Port");
+
 	/* virtual methods */
 	parent_class->ce_page_validate_v = ce_page_validate_v;
 }
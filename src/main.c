@@ -12,12 +12,15 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <signal.h>
 
 #include "applet.h"
 
 gboolean shell_debug = FALSE;
 gboolean with_agent = TRUE;
 gboolean with_appindicator = FALSE;
+guint icon_update_interval = APPLET_ICON_UPDATE_INTERVAL;
+gboolean startup_timing = FALSE;
 
 static void
 usage (const char *progname)
@@ -38,6 +41,9 @@ int main (int argc, char *argv[])
 	guint32 i;
 	int status;
 
+	if (g_getenv ("NMA_STARTUP_TIMING"))
+		startup_timing = TRUE;
+
 	for (i = 1; i < argc; i++) {
 		if (!strcmp (argv[i], "--help")) {
 			usage (argv[0]);
@@ -47,6 +53,10 @@ int main (int argc, char *argv[])
 			shell_debug = TRUE;
 		else if (!strcmp (argv[i], "--no-agent"))
 			with_agent = FALSE;
+		else if (!strcmp (argv[i], "--startup-timing"))
+			startup_timing = TRUE;
+		else if (g_str_has_prefix (argv[i], "--icon-update-interval="))
+			icon_update_interval = strtoul (argv[i] + strlen ("--icon-update-interval="), NULL, 10);
 		else if (!strcmp (argv[i], "--indicator")) {
 #ifdef WITH_APPINDICATOR
 			with_appindicator = TRUE;
@@ -56,6 +66,10 @@ int main (int argc, char *argv[])
 		}
 	}
 
+	/* An auth-dialog that exits before reading all its input should
+	 * show up as EPIPE, rather than take the applet down with it. */
+	signal (SIGPIPE, SIG_IGN);
+
 	bindtextdomain (GETTEXT_PACKAGE, NMALOCALEDIR);
 	bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
 	if (!with_appindicator)
@@ -26,6 +26,15 @@ typedef struct {
 
 	char *desc_string;
 	guint32    int_strength;
+
+	/* Kept for in-place updates */
+	NMApplet *applet;
+	char *connection_name;
+	char *provider;
+	gboolean active;
+	gboolean enabled;
+	guint32 technology;
+	guint32 state;
 } NMMbMenuItemPrivate;
 
 static const char *
@@ -74,116 +83,167 @@ update_label (NMMbMenuItem *item, gboolean use_bold)
 		gtk_label_set_text (GTK_LABEL (priv->desc), priv->desc_string);
 }
 
-GtkWidget *
-nm_mb_menu_item_new (const char *connection_name,
-                     guint32 strength,
-                     const char *provider,
-                     gboolean active,
-                     guint32 technology,
-                     guint32 state,
-                     gboolean enabled,
-                     NMApplet *applet)
+static char *
+build_desc_string (const char *connection_name,
+                   const char *provider,
+                   guint32 technology,
+                   guint32 state)
 {
-	NMMbMenuItem *item;
-	NMMbMenuItemPrivate *priv;
 	const char *tech_name;
 
-	item = g_object_new (NM_TYPE_MB_MENU_ITEM, NULL);
-	g_assert (item);
-
-	priv = NM_MB_MENU_ITEM_GET_PRIVATE (item);
-	priv->int_strength = strength;
-
 	tech_name = get_tech_name (technology);
 
-	/* Construct the description string */
 	switch (state) {
 	default:
 	case MB_STATE_UNKNOWN:
-		priv->desc_string = g_strdup (_("not enabled"));
-		break;
+		return g_strdup (_("not enabled"));
 	case MB_STATE_IDLE:
 		if (connection_name)
-			priv->desc_string = g_strdup (connection_name);
+			return g_strdup (connection_name);
 		else
-			priv->desc_string = g_strdup (_("not registered"));
-		break;
+			return g_strdup (_("not registered"));
 	case MB_STATE_HOME:
 		if (connection_name) {
 			if (provider && tech_name)
-				priv->desc_string = g_strdup_printf ("%s (%s %s)", connection_name, provider, tech_name);
+				return g_strdup_printf ("%s (%s %s)", connection_name, provider, tech_name);
 			else if (provider || tech_name)
-				priv->desc_string = g_strdup_printf ("%s (%s)", connection_name, provider ? provider : tech_name);
+				return g_strdup_printf ("%s (%s)", connection_name, provider ? provider : tech_name);
 			else
-				priv->desc_string = g_strdup_printf ("%s", connection_name);
+				return g_strdup_printf ("%s", connection_name);
 		} else {
 			if (provider) {
 				if (tech_name)
-					priv->desc_string = g_strdup_printf ("%s %s", provider, tech_name);
+					return g_strdup_printf ("%s %s", provider, tech_name);
 				else
-					priv->desc_string = g_strdup_printf ("%s", provider);
+					return g_strdup_printf ("%s", provider);
 			} else {
 				if (tech_name)
-					priv->desc_string = g_strdup_printf (_("Home network (%s)"), tech_name);
+					return g_strdup_printf (_("Home network (%s)"), tech_name);
 				else
-					priv->desc_string = g_strdup_printf (_("Home network"));
+					return g_strdup_printf (_("Home network"));
 			}
 		}
-		break;
 	case MB_STATE_SEARCHING:
 		if (connection_name)
-			priv->desc_string = g_strdup (connection_name);
+			return g_strdup (connection_name);
 		else
-			priv->desc_string = g_strdup (_("searching"));
-		break;
+			return g_strdup (_("searching"));
 	case MB_STATE_DENIED:
-		priv->desc_string = g_strdup (_("registration denied"));
-		break;
+		return g_strdup (_("registration denied"));
 	case MB_STATE_ROAMING:
 		if (connection_name) {
 			if (tech_name)
-				priv->desc_string = g_strdup_printf (_("%s (%s roaming)"), connection_name, tech_name);
+				return g_strdup_printf (_("%s (%s roaming)"), connection_name, tech_name);
 			else
-				priv->desc_string = g_strdup_printf (_("%s (roaming)"), connection_name);
+				return g_strdup_printf (_("%s (roaming)"), connection_name);
 		} else {
 			if (provider) {
 				if (tech_name)
-					priv->desc_string = g_strdup_printf (_("%s (%s roaming)"), provider, tech_name);
+					return g_strdup_printf (_("%s (%s roaming)"), provider, tech_name);
 				else
-					priv->desc_string = g_strdup_printf (_("%s (roaming)"), provider);
+					return g_strdup_printf (_("%s (roaming)"), provider);
 			} else {
 				if (tech_name)
-					priv->desc_string = g_strdup_printf (_("Roaming network (%s)"), tech_name);
+					return g_strdup_printf (_("Roaming network (%s)"), tech_name);
 				else
-					priv->desc_string = g_strdup_printf (_("Roaming network"));
+					return g_strdup_printf (_("Roaming network"));
 			}
 		}
-		break;
 	}
+}
 
-	update_label (item, (enabled && connection_name && active));
+static void
+update_strength (NMMbMenuItem *item)
+{
+	NMMbMenuItemPrivate *priv = NM_MB_MENU_ITEM_GET_PRIVATE (item);
+	const char *icon_name;
+	GdkPixbuf *icon;
 
-	/* And the strength icon, if we have strength information at all */
-	if (enabled && strength) {
-		const char *icon_name = mobile_helper_get_quality_icon_name (strength);
-		GdkPixbuf *icon = nma_icon_check_and_load (icon_name, applet);
+	/* Only show the strength icon if we have strength information at all */
+	if (!priv->enabled || !priv->int_strength) {
+		gtk_image_clear (GTK_IMAGE (priv->strength));
+		return;
+	}
 
-		if (INDICATOR_ENABLED (applet)) {
-			/* app_indicator only uses GdkPixbuf */
-			gtk_image_set_from_pixbuf (GTK_IMAGE (priv->strength), icon);
-		} else {
-			int scale = gtk_widget_get_scale_factor (GTK_WIDGET (priv->strength));
-			cairo_surface_t *surface;
+	icon_name = mobile_helper_get_quality_icon_name (priv->int_strength);
+	icon = nma_icon_check_and_load (icon_name, priv->applet);
 
-			surface = gdk_cairo_surface_create_from_pixbuf (icon, scale, NULL);
-			gtk_image_set_from_surface (GTK_IMAGE (priv->strength), surface);
-			cairo_surface_destroy (surface);
-		}
+	if (INDICATOR_ENABLED (priv->applet)) {
+		/* app_indicator only uses GdkPixbuf */
+		gtk_image_set_from_pixbuf (GTK_IMAGE (priv->strength), icon);
+	} else {
+		int scale = gtk_widget_get_scale_factor (GTK_WIDGET (priv->strength));
+		cairo_surface_t *surface;
+
+		surface = gdk_cairo_surface_create_from_pixbuf (icon, scale, NULL);
+		gtk_image_set_from_surface (GTK_IMAGE (priv->strength), surface);
+		cairo_surface_destroy (surface);
 	}
+}
+
+GtkWidget *
+nm_mb_menu_item_new (const char *connection_name,
+                     guint32 strength,
+                     const char *provider,
+                     gboolean active,
+                     guint32 technology,
+                     guint32 state,
+                     gboolean enabled,
+                     NMApplet *applet)
+{
+	NMMbMenuItem *item;
+	NMMbMenuItemPrivate *priv;
+
+	item = g_object_new (NM_TYPE_MB_MENU_ITEM, NULL);
+	g_assert (item);
+
+	priv = NM_MB_MENU_ITEM_GET_PRIVATE (item);
+	priv->int_strength = strength;
+	priv->applet = applet;
+	priv->connection_name = g_strdup (connection_name);
+	priv->provider = g_strdup (provider);
+	priv->active = active;
+	priv->enabled = enabled;
+	priv->technology = technology;
+	priv->state = state;
+
+	priv->desc_string = build_desc_string (connection_name, provider, technology, state);
+	update_label (item, (enabled && connection_name && active));
+	update_strength (item);
 
 	return GTK_WIDGET (item);
 }
 
+/* Refresh the label and strength icon of an item that is already in the
+ * menu, so that signal and registration changes don't need a menu rebuild.
+ */
+void
+nm_mb_menu_item_update (NMMbMenuItem *item,
+                        guint32 strength,
+                        guint32 technology,
+                        guint32 state)
+{
+	NMMbMenuItemPrivate *priv;
+
+	g_return_if_fail (NM_IS_MB_MENU_ITEM (item));
+
+	priv = NM_MB_MENU_ITEM_GET_PRIVATE (item);
+
+	if (technology != priv->technology || state != priv->state) {
+		priv->technology = technology;
+		priv->state = state;
+		g_free (priv->desc_string);
+		priv->desc_string = build_desc_string (priv->connection_name, priv->provider,
+		                                       technology, state);
+		update_label (item, (priv->enabled && priv->connection_name && priv->active));
+	}
+
+	if (strength != priv->int_strength) {
+		priv->int_strength = strength;
+		update_strength (item);
+	}
+}
+
 /*******************************************************/
 
 static void
@@ -209,7 +269,11 @@ nm_mb_menu_item_init (NMMbMenuItem *self)
 static void
 finalize (GObject *object)
 {
-	g_free (NM_MB_MENU_ITEM_GET_PRIVATE (object)->desc_string);
+	NMMbMenuItemPrivate *priv = NM_MB_MENU_ITEM_GET_PRIVATE (object);
+
+	g_free (priv->desc_string);
+	g_free (priv->connection_name);
+	g_free (priv->provider);
 
 	G_OBJECT_CLASS (nm_mb_menu_item_parent_class)->finalize (object);
 }
@@ -41,5 +41,10 @@ GtkWidget *nm_mb_menu_item_new (const char *connection_name,
                                 gboolean enabled,
                                 NMApplet *applet);
 
+void       nm_mb_menu_item_update (NMMbMenuItem *item,
+                                   guint32 strength,
+                                   guint32 technology,
+                                   guint32 state);
+
 #endif /* _MB_MENU_ITEM_H_ */
 
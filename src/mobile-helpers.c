@@ -16,18 +16,38 @@
 #include "mobile-helpers.h"
 #include "applet-dialogs.h"
 
-GdkPixbuf *
-mobile_helper_get_status_pixbuf (guint32 quality,
-                                 gboolean quality_valid,
-                                 guint32 state,
-                                 guint32 access_tech,
-                                 NMApplet *applet)
+static const char *quality_icon_names[] = {
+	"nm-signal-00",
+	"nm-signal-25",
+	"nm-signal-50",
+	"nm-signal-75",
+	"nm-signal-100",
+};
+
+guint
+mobile_helper_get_quality_bucket (guint32 quality)
+{
+	if (quality > 80)
+		return 4;
+	else if (quality > 55)
+		return 3;
+	else if (quality > 30)
+		return 2;
+	else if (quality > 5)
+		return 1;
+	else
+		return 0;
+}
+
+static GdkPixbuf *
+compose_status_pixbuf (guint bucket,
+                       gboolean roaming,
+                       guint32 access_tech,
+                       NMApplet *applet)
 {
 	GdkPixbuf *pixbuf, *qual_pixbuf, *tmp;
 
-	if (!quality_valid)
-		quality = 0;
-	qual_pixbuf = nma_icon_check_and_load (mobile_helper_get_quality_icon_name (quality), applet);
+	qual_pixbuf = nma_icon_check_and_load (quality_icon_names[bucket], applet);
 
 	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
 	                         TRUE,
@@ -58,7 +78,7 @@ mobile_helper_get_status_pixbuf (guint32 quality,
 	}
 
 	/* And finally the roaming or technology icon */
-	if (state == MB_STATE_ROAMING) {
+	if (roaming) {
 		tmp = nma_icon_check_and_load ("nm-mb-roam", applet);
 		if (tmp) {
 			gdk_pixbuf_composite (tmp, pixbuf, 0, 0,
@@ -85,23 +105,56 @@ mobile_helper_get_status_pixbuf (guint32 quality,
 		}
 	}
 
-	/* 'pixbuf' will be freed by the caller */
 	return pixbuf;
 }
 
+/* The composited icons only depend on a handful of states, so they are
+ * kept in applet->status_pixbuf_cache until the icons get reloaded.
+ */
+#define STATUS_PIXBUF_KEY(bucket, roaming, tech, scale) \
+	GUINT_TO_POINTER (  ((bucket) & 0x7) \
+	                  | ((roaming) ? 0x8 : 0) \
+	                  | (((tech) & 0xFF) << 4) \
+	                  | (((scale) & 0xFF) << 12))
+
+GdkPixbuf *
+mobile_helper_get_status_pixbuf (guint32 quality,
+                                 gboolean quality_valid,
+                                 guint32 state,
+                                 guint32 access_tech,
+                                 NMApplet *applet)
+{
+	GdkPixbuf *pixbuf;
+	gboolean roaming = (state == MB_STATE_ROAMING);
+	gpointer key;
+	guint bucket;
+	int scale;
+
+	if (!quality_valid)
+		quality = 0;
+	bucket = mobile_helper_get_quality_bucket (quality);
+
+	/* The tech badge is not shown while roaming */
+	if (roaming || !mobile_helper_get_tech_icon_name (access_tech))
+		access_tech = MB_TECH_UNKNOWN;
+
+	scale = gdk_window_get_scale_factor (gdk_get_default_root_window ());
+	key = STATUS_PIXBUF_KEY (bucket, roaming, access_tech, scale);
+
+	pixbuf = g_hash_table_lookup (applet->status_pixbuf_cache, key);
+	if (!pixbuf) {
+		pixbuf = compose_status_pixbuf (bucket, roaming, access_tech, applet);
+		g_hash_table_insert (applet->status_pixbuf_cache, key, pixbuf);
+	}
+
+	/* The returned reference will be released by the caller */
+	return g_object_ref (pixbuf);
+}
+
 const char *
 mobile_helper_get_quality_icon_name (guint32 quality)
 {
-	if (quality > 80)
-		return "nm-signal-100";
-	else if (quality > 55)
-		return "nm-signal-75";
-	else if (quality > 30)
-		return "nm-signal-50";
-	else if (quality > 5)
-		return "nm-signal-25";
-	else
-		return "nm-signal-00";
+	return quality_icon_names[mobile_helper_get_quality_bucket (quality)];
 }
 
 const char *
@@ -618,16 +671,139 @@ mobile_helper_get_icon (NMDevice *device,
 
 /********************************************************************/
 
+/* Process-wide index of the mobile providers database, loaded in the
+ * background on first use and shared by all modems.
+ */
+typedef struct {
+	MobileHelperProvidersLoadedFunc func;
+	gpointer user_data;
+} ProvidersWatch;
+
+static struct {
+	NMAMobileProvidersDatabase *mpd;
+	gboolean loading;
+	gboolean failed;
+
+	/* MCC/MNC string and CDMA SID -> provider name; "" for misses */
+	GHashTable *mcc_mnc;
+	GHashTable *sid;
+
+	GSList *watches;
+} providers;
+
+static void
+providers_index_add (NMAMobileProvider *provider, gpointer user_data)
+{
+	const char *const *mcc_mnc;
+	const guint32 *sid;
+	const char *name;
+
+	name = nma_mobile_provider_get_name (provider);
+	if (!name)
+		return;
+
+	mcc_mnc = nma_mobile_provider_get_3gpp_mcc_mnc (provider);
+	for (; mcc_mnc && *mcc_mnc; mcc_mnc++) {
+		/* The database lookup returns the first match */
+		if (!g_hash_table_contains (providers.mcc_mnc, *mcc_mnc))
+			g_hash_table_insert (providers.mcc_mnc, (gpointer) *mcc_mnc, (gpointer) name);
+	}
+
+	sid = nma_mobile_provider_get_cdma_sid (provider);
+	for (; sid && *sid; sid++) {
+		if (!g_hash_table_contains (providers.sid, GUINT_TO_POINTER (*sid)))
+			g_hash_table_insert (providers.sid, GUINT_TO_POINTER (*sid), (gpointer) name);
+	}
+}
+
+static void
+providers_loaded_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GError *error = NULL;
+	GHashTableIter iter;
+	NMACountryInfo *country;
+	GSList *watches, *l;
+
+	providers.loading = FALSE;
+	providers.mpd = nma_mobile_providers_database_new_finish (result, &error);
+	if (!providers.mpd) {
+		g_warning ("Couldn't read database: %s", error->message);
+		g_error_free (error);
+		providers.failed = TRUE;
+		return;
+	}
+
+	providers.mcc_mnc = g_hash_table_new (g_str_hash, g_str_equal);
+	providers.sid = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	g_hash_table_iter_init (&iter, nma_mobile_providers_database_get_countries (providers.mpd));
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &country))
+		g_slist_foreach (nma_country_info_get_providers (country), (GFunc) providers_index_add, NULL);
+
+	/* Let the modems resolve their operator names now */
+	watches = g_slist_copy (providers.watches);
+	for (l = watches; l; l = l->next) {
+		ProvidersWatch *watch = l->data;
+
+		if (g_slist_find (providers.watches, watch))
+			watch->func (watch->user_data);
+	}
+	g_slist_free (watches);
+}
+
+/* Returns TRUE if the index can be used; otherwise starts loading it once */
+static gboolean
+providers_index_ready (void)
+{
+	if (providers.mpd)
+		return TRUE;
+
+	if (!providers.loading && !providers.failed) {
+		providers.loading = TRUE;
+		nma_mobile_providers_database_new (NULL, NULL, NULL, providers_loaded_cb, NULL);
+	}
+	return FALSE;
+}
+
+/* Operator names can't be resolved until the providers database has been
+ * loaded in the background; @func is called when that happens.  @user_data
+ * also identifies the watch for mobile_helper_providers_unwatch().
+ */
+void
+mobile_helper_providers_watch (MobileHelperProvidersLoadedFunc func, gpointer user_data)
+{
+	ProvidersWatch *watch;
+
+	watch = g_slice_new (ProvidersWatch);
+	watch->func = func;
+	watch->user_data = user_data;
+	providers.watches = g_slist_prepend (providers.watches, watch);
+}
+
+void
+mobile_helper_providers_unwatch (gpointer user_data)
+{
+	GSList *l;
+
+	for (l = providers.watches; l; l = l->next) {
+		ProvidersWatch *watch = l->data;
+
+		if (watch->user_data == user_data) {
+			providers.watches = g_slist_delete_link (providers.watches, l);
+			g_slice_free (ProvidersWatch, watch);
+			return;
+		}
+	}
+}
+
 char *
-mobile_helper_parse_3gpp_operator_name (NMAMobileProvidersDatabase **mpd, /* I/O */
-                                        const char *orig,
+mobile_helper_parse_3gpp_operator_name (const char *orig,
                                         const char *op_code)
 {
 	NMAMobileProvider *provider;
+	const char *name;
 	guint i, orig_len;
 
-	g_assert (mpd != NULL);
-
 	/* Some devices return the MCC/MNC if they haven't fully initialized
 	 * or gotten all the info from the network yet.  Handle that.
 	 */
@@ -654,43 +830,33 @@ mobile_helper_parse_3gpp_operator_name (NMAMobileProvidersDatabase **mpd, /* I/O
 	 * probably an MCC/MNC.  Look that up.
 	 */
 
-	if (*mpd == NULL) {
-		GError *error = NULL;
-
-		*mpd = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
-		if (*mpd == NULL) {
-			g_warning ("Couldn't read database: %s", error->message);
-			g_error_free (error);
-			return strdup (orig);
-		}
+	if (!providers_index_ready ())
+		return strdup (orig);
+
+	name = g_hash_table_lookup (providers.mcc_mnc, orig);
+	if (!name) {
+		/* Not listed verbatim; let the database have a go and remember the answer */
+		provider = nma_mobile_providers_database_lookup_3gpp_mcc_mnc (providers.mpd, orig);
+		name = provider ? nma_mobile_provider_get_name (provider) : NULL;
+		g_hash_table_insert (providers.mcc_mnc,
+		                     (gpointer) g_intern_string (orig),
+		                     (gpointer) (name ?: ""));
 	}
 
-	provider = nma_mobile_providers_database_lookup_3gpp_mcc_mnc (*mpd, orig);
-	return (provider ? g_strdup (nma_mobile_provider_get_name (provider)) : NULL);
+	return name && name[0] ? g_strdup (name) : NULL;
 }
 
 char *
-mobile_helper_parse_3gpp2_operator_name (NMAMobileProvidersDatabase **mpd, /* I/O */
-                                         guint32 sid)
+mobile_helper_parse_3gpp2_operator_name (guint32 sid)
 {
-	NMAMobileProvider *provider;
-
-	g_assert (mpd != NULL);
+	const char *name;
 
 	if (!sid)
 		return NULL;
 
-	if (*mpd == NULL) {
-		GError *error = NULL;
-
-		*mpd = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
-		if (*mpd == NULL) {
-			g_warning ("Couldn't read database: %s", error->message);
-			g_error_free (error);
-			return NULL;
-		}
-	}
+	if (!providers_index_ready ())
+		return NULL;
 
-	provider = nma_mobile_providers_database_lookup_cdma_sid (*mpd, sid);
-	return (provider ? g_strdup (nma_mobile_provider_get_name (provider)) : NULL);
+	name = g_hash_table_lookup (providers.sid, GUINT_TO_POINTER (sid));
+	return name ? g_strdup (name) : NULL;
 }
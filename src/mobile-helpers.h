@@ -46,6 +46,7 @@ GdkPixbuf *mobile_helper_get_status_pixbuf (guint32 quality,
                                             guint32 access_tech,
                                             NMApplet *applet);
 
+guint mobile_helper_get_quality_bucket (guint32 quality);
 const char *mobile_helper_get_quality_icon_name (guint32 quality);
 const char *mobile_helper_get_tech_icon_name (guint32 tech);
 
@@ -94,11 +95,15 @@ void mobile_helper_get_icon (NMDevice *device,
 
 /********************************************************************/
 
-char *mobile_helper_parse_3gpp_operator_name (NMAMobileProvidersDatabase **mpd,
-                                              const char *orig,
+typedef void (*MobileHelperProvidersLoadedFunc) (gpointer user_data);
+
+void mobile_helper_providers_watch (MobileHelperProvidersLoadedFunc func,
+                                    gpointer user_data);
+void mobile_helper_providers_unwatch (gpointer user_data);
+
+char *mobile_helper_parse_3gpp_operator_name (const char *orig,
                                               const char *op_code);
 
-char *mobile_helper_parse_3gpp2_operator_name (NMAMobileProvidersDatabase **mpd,
-                                               guint32 sid);
+char *mobile_helper_parse_3gpp2_operator_name (guint32 sid);
 
 #endif  /* APPLET_MOBILE_HELPERS_H */
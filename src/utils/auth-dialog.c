@@ -0,0 +1,929 @@
+// SPDX-License-Identifier: GPL-2.0+
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "auth-dialog.h"
+
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <glib-unix.h>
+
+#include "utils.h"
+#include "nm-utils/nm-shared-utils.h"
+
+/*****************************************************************************/
+
+/*
+ * AuthDialogWriter
+ *
+ * Streams data to an auth-dialog's stdin without blocking the main loop.
+ * The data is queued as iovecs and written with writev() whenever the pipe
+ * has room.  Nothing is copied: auth_dialog_writer_add() and
+ * auth_dialog_writer_add_value() point into the caller's buffers, which must
+ * stay unchanged until the write has finished or the writer is freed.  The
+ * writer can hold a reference on the object the data lives in, and take
+ * over strings generated for it.
+ */
+struct _AuthDialogWriter {
+	int fd;
+	gboolean close_fd;
+
+	GArray *iov;
+	guint iov_first;
+	GPtrArray *strings;
+	GPtrArray *objects;
+
+	GIOChannel *channel;
+	guint out_id;
+	AuthDialogWriterDoneFunc func;
+	gpointer user_data;
+};
+
+AuthDialogWriter *
+auth_dialog_writer_new (int fd, gboolean close_fd)
+{
+	AuthDialogWriter *writer;
+
+	g_return_val_if_fail (fd >= 0, NULL);
+
+	writer = g_slice_new0 (AuthDialogWriter);
+	writer->fd = fd;
+	writer->close_fd = close_fd;
+	writer->iov = g_array_new (FALSE, FALSE, sizeof (struct iovec));
+	writer->strings = g_ptr_array_new_with_free_func (g_free);
+	writer->objects = g_ptr_array_new_with_free_func (g_object_unref);
+	return writer;
+}
+
+/*
+ * auth_dialog_writer_free
+ *
+ * Frees @writer, aborting a write that is still in progress.  The done
+ * callback is not called.
+ */
+void
+auth_dialog_writer_free (AuthDialogWriter *writer)
+{
+	if (!writer)
+		return;
+
+	nm_clear_g_source (&writer->out_id);
+	if (writer->channel)
+		g_io_channel_unref (writer->channel);
+	if (writer->close_fd)
+		nm_close (writer->fd);
+
+	g_array_unref (writer->iov);
+	g_ptr_array_unref (writer->strings);
+	g_ptr_array_unref (writer->objects);
+	g_slice_free (AuthDialogWriter, writer);
+}
+
+void
+auth_dialog_writer_add (AuthDialogWriter *writer, const char *data, gsize len)
+{
+	struct iovec iov;
+
+	g_return_if_fail (writer);
+
+	if (!len)
+		return;
+
+	iov.iov_base = (void *) data;
+	iov.iov_len = len;
+	g_array_append_val (writer->iov, iov);
+}
+
+void
+auth_dialog_writer_take (AuthDialogWriter *writer, char *str)
+{
+	g_return_if_fail (writer);
+	g_return_if_fail (str);
+
+	g_ptr_array_add (writer->strings, str);
+	auth_dialog_writer_add (writer, str, strlen (str));
+}
+
+/*
+ * auth_dialog_writer_hold
+ *
+ * Keeps a reference on @object until @writer is freed, for data that
+ * points into it.
+ */
+void
+auth_dialog_writer_hold (AuthDialogWriter *writer, gpointer object)
+{
+	g_return_if_fail (writer);
+	g_return_if_fail (G_IS_OBJECT (object));
+
+	g_ptr_array_add (writer->objects, g_object_ref (object));
+}
+
+/*
+ * auth_dialog_writer_add_value
+ *
+ * Adds a "TAG=value" line, pointing into @tag and @val.  The protocol is
+ * line based, so newlines in the value are written as spaces.
+ */
+void
+auth_dialog_writer_add_value (AuthDialogWriter *writer,
+                              const char *tag,
+                              const char *val)
+{
+	const char *s;
+
+	g_return_if_fail (writer);
+	g_return_if_fail (tag && tag[0]);
+	g_return_if_fail (val);
+
+	auth_dialog_writer_add (writer, tag, strlen (tag));
+	auth_dialog_writer_add (writer, "=", 1);
+	while ((s = strchr (val, '\n'))) {
+		auth_dialog_writer_add (writer, val, s - val);
+		auth_dialog_writer_add (writer, " ", 1);
+		val = s + 1;
+	}
+	auth_dialog_writer_add (writer, val, strlen (val));
+	auth_dialog_writer_add (writer, "\n", 1);
+}
+
+/* Like auth_dialog_writer_add_value(), for a value the writer takes over. */
+void
+auth_dialog_writer_take_value (AuthDialogWriter *writer,
+                               const char *tag,
+                               char *val)
+{
+	g_return_if_fail (writer);
+	g_return_if_fail (val);
+
+	g_ptr_array_add (writer->strings, val);
+	auth_dialog_writer_add_value (writer, tag, val);
+}
+
+/* Writes as much as the pipe takes. Returns TRUE once everything is out. */
+static gboolean
+writer_flush (AuthDialogWriter *writer, GError **error)
+{
+	struct iovec *iov = (struct iovec *) writer->iov->data;
+	gssize w;
+	int errsv;
+
+	while (writer->iov_first < writer->iov->len) {
+		w = writev (writer->fd,
+		            &iov[writer->iov_first],
+		            MIN (writer->iov->len - writer->iov_first, IOV_MAX));
+		if (w < 0) {
+			errsv = errno;
+			if (errsv == EINTR)
+				continue;
+			if (errsv == EAGAIN)
+				return FALSE;
+			g_set_error (error,
+			             NM_SECRET_AGENT_ERROR,
+			             NM_SECRET_AGENT_ERROR_FAILED,
+			             _("Failed to write connection to VPN UI: %s (%d)"), g_strerror (errsv), errsv);
+			return FALSE;
+		}
+
+		/* Skip what got written, possibly ending in the middle of an iovec */
+		while (w > 0) {
+			struct iovec *cur = &iov[writer->iov_first];
+
+			if ((gsize) w < cur->iov_len) {
+				cur->iov_base = (char *) cur->iov_base + w;
+				cur->iov_len -= w;
+				break;
+			}
+			w -= cur->iov_len;
+			writer->iov_first++;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+writer_out_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	AuthDialogWriter *writer = user_data;
+	gs_free_error GError *error = NULL;
+
+	if (!writer_flush (writer, &error) && !error) {
+		/* Wait for the reader to catch up */
+		return G_SOURCE_CONTINUE;
+	}
+
+	writer->out_id = 0;
+	writer->func (error, writer->user_data);
+	auth_dialog_writer_free (writer);
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * auth_dialog_writer_start
+ *
+ * Starts writing once the main loop sees the pipe writable.  @func is called
+ * when all data has been written or writing failed, after which the writer
+ * is freed.  Writing to a reader that went away fails with EPIPE only if
+ * SIGPIPE is ignored, which the applet does at startup.
+ *
+ * Returns: %FALSE if the pipe couldn't be made non-blocking; the writer
+ *   is then left to the caller to free.
+ */
+gboolean
+auth_dialog_writer_start (AuthDialogWriter *writer,
+                          AuthDialogWriterDoneFunc func,
+                          gpointer user_data,
+                          GError **error)
+{
+	g_return_val_if_fail (writer, FALSE);
+	g_return_val_if_fail (func, FALSE);
+	g_return_val_if_fail (!writer->channel, FALSE);
+
+	if (!g_unix_set_fd_nonblocking (writer->fd, TRUE, error))
+		return FALSE;
+
+	writer->func = func;
+	writer->user_data = user_data;
+
+	writer->channel = g_io_channel_unix_new (writer->fd);
+	writer->out_id = g_io_add_watch (writer->channel,
+	                                 G_IO_OUT | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
+	                                 writer_out_cb,
+	                                 writer);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+child_setup (gpointer user_data)
+{
+	/* We are in the child process at this point */
+	pid_t pid = getpid ();
+	setpgid (pid, pid);
+}
+
+/*
+ * auth_dialog_spawn_argv
+ *
+ * Spawns an auth-dialog with pipes to its stdin and stdout.  The child is
+ * not reaped automatically; use g_child_watch_add() or auth_dialog_kill().
+ */
+gboolean
+auth_dialog_spawn_argv (const char *const*argv,
+                        GPid *out_pid,
+                        int *out_stdin,
+                        int *out_stdout,
+                        GError **error)
+{
+	gs_free const char **envp = NULL;
+	gsize environ_len;
+	gsize i, j;
+
+	environ_len = NM_PTRARRAY_LEN (environ);
+	envp = g_new (const char *, environ_len + 1);
+	memcpy (envp, environ, sizeof (const char *) * environ_len);
+	for (i = 0, j = 0; i < environ_len; i++) {
+		const char *e = environ[i];
+
+		if (g_str_has_prefix (e, "G_MESSAGES_DEBUG=")) {
+			/* skip this environment variable. We interact with the auth-dialog via stdout.
+			 * G_MESSAGES_DEBUG may enable additional debugging messages from GTK. */
+			continue;
+		}
+		envp[j++] = e;
+	}
+	envp[j] = NULL;
+
+	return g_spawn_async_with_pipes (NULL,
+	                                 (char **) argv,
+	                                 (char **) envp,
+	                                 G_SPAWN_DO_NOT_REAP_CHILD,
+	                                 child_setup,
+	                                 NULL,
+	                                 out_pid,
+	                                 out_stdin,
+	                                 out_stdout,
+	                                 NULL,
+	                                 error);
+}
+
+static gboolean
+ensure_killed (gpointer data)
+{
+	pid_t pid = GPOINTER_TO_INT (data);
+
+	kill (pid, SIGKILL);
+	waitpid (pid, NULL, 0);
+	return FALSE;
+}
+
+/*
+ * auth_dialog_kill
+ *
+ * Terminates and reaps an auth-dialog whose child watch, if any, is gone.
+ */
+void
+auth_dialog_kill (GPid pid)
+{
+	if (kill (pid, SIGTERM) == 0)
+		g_timeout_add_seconds (2, ensure_killed, GINT_TO_POINTER (pid));
+	else {
+		kill (pid, SIGKILL);
+		waitpid (pid, NULL, 0);
+	}
+}
+
+typedef struct {
+	GPid pid;
+	guint timeout_id;
+} ReleasedChild;
+
+static void
+released_child_exited_cb (GPid pid, int status, gpointer user_data)
+{
+	ReleasedChild *child = user_data;
+
+	nm_clear_g_source (&child->timeout_id);
+	g_slice_free (ReleasedChild, child);
+}
+
+static gboolean
+released_child_timeout_cb (gpointer user_data)
+{
+	ReleasedChild *child = user_data;
+
+	/* The child watch reaps it */
+	child->timeout_id = 0;
+	kill (child->pid, SIGKILL);
+	return G_SOURCE_REMOVE;
+}
+
+/*
+ * auth_dialog_release
+ *
+ * Leaves an auth-dialog that is done and was told to quit to exit on its
+ * own, and reaps it.  It is only killed if it's still around after
+ * @timeout_sec.  Its child watch, if any, must be gone.
+ */
+void
+auth_dialog_release (GPid pid, guint timeout_sec)
+{
+	ReleasedChild *child;
+
+	child = g_slice_new0 (ReleasedChild);
+	child->pid = pid;
+	child->timeout_id = g_timeout_add_seconds (timeout_sec, released_child_timeout_cb, child);
+	g_child_watch_add (pid, released_child_exited_cb, child);
+}
+
+/*****************************************************************************/
+
+/*
+ * AuthDialogPool
+ *
+ * Runs auth-dialogs in persistent mode, where they serve one request after
+ * the other instead of exiting after the first one.  A job's write function
+ * puts the request on the helper's stdin, and the helper answers with
+ * "CANCEL" on a line of its own, or with "OK" followed by the usual secret
+ * name/value line pairs and an empty line.
+ *
+ * A job that finds no idle helper gets a new one, up to @max_helpers (0 for
+ * no limit), so that a dialog waiting for the user doesn't hold up requests
+ * for other connections.  Beyond that, jobs wait in a queue.  A helper that
+ * stays idle for @idle_timeout_ms is sent "QUIT" and left to exit; it only
+ * gets killed if it doesn't.
+ */
+
+#define HELPER_QUIT_TIMEOUT_SEC 5
+
+typedef struct {
+	AuthDialogPool *pool;
+
+	GPid pid;
+	guint watch_id;
+	int child_stdin;
+	AuthDialogWriter *writer;
+	GIOChannel *channel;
+	guint channel_eventid;
+	UtilsSecretsParser *parser;
+
+	AuthDialogJob *current;
+	guint timeout_id;
+} Helper;
+
+struct _AuthDialogJob {
+	Helper *helper;
+	AuthDialogJobWriteFunc write_func;
+	AuthDialogJobSecretFunc secret_func;
+	AuthDialogJobDoneFunc done_func;
+	gpointer user_data;
+};
+
+struct _AuthDialogPool {
+	char **argv;
+	guint max_helpers;
+	guint idle_timeout_ms;
+
+	GPtrArray *helpers;
+	/* Helpers that were sent "QUIT" and haven't exited yet */
+	GPtrArray *quitting;
+
+	GQueue queue;
+	guint dispatch_id;
+};
+
+static void pool_schedule_dispatch (AuthDialogPool *pool);
+
+static void
+job_complete (AuthDialogJob *job, GError *error)
+{
+	job->done_func (error, job->user_data);
+	g_slice_free (AuthDialogJob, job);
+}
+
+static void
+helper_free (Helper *helper)
+{
+	nm_clear_g_source (&helper->timeout_id);
+	nm_clear_g_source (&helper->watch_id);
+	nm_clear_g_source (&helper->channel_eventid);
+	if (helper->channel)
+		g_io_channel_unref (helper->channel);
+	auth_dialog_writer_free (helper->writer);
+	if (helper->child_stdin >= 0)
+		nm_close (helper->child_stdin);
+
+	if (helper->pid)
+		auth_dialog_kill (helper->pid);
+
+	utils_secrets_parser_free (helper->parser);
+	g_slice_free (Helper, helper);
+}
+
+/* Drops a helper that died or misbehaved. The job it was serving fails
+ * with @error; queued ones go to other helpers. */
+static void
+helper_drop (Helper *helper, GError *error)
+{
+	AuthDialogPool *pool = helper->pool;
+	AuthDialogJob *job = helper->current;
+	gs_free_error GError *local = NULL;
+
+	helper->current = NULL;
+	g_ptr_array_remove (pool->helpers, helper);
+	helper_free (helper);
+	pool_schedule_dispatch (pool);
+
+	if (job) {
+		job->helper = NULL;
+		if (!error) {
+			error = local = g_error_new_literal (NM_SECRET_AGENT_ERROR,
+			                                     NM_SECRET_AGENT_ERROR_FAILED,
+			                                     "VPN authentication helper failed");
+		}
+		job_complete (job, error);
+	}
+}
+
+static void
+helper_written_cb (GError *error, gpointer user_data)
+{
+	Helper *helper = user_data;
+
+	helper->writer = NULL;
+	if (error)
+		helper_drop (helper, error);
+	else if (!helper->current) {
+		/* It answered before reading all of the request */
+		pool_schedule_dispatch (helper->pool);
+	}
+}
+
+static void
+helper_quit_written_cb (GError *error, gpointer user_data)
+{
+	Helper *helper = user_data;
+
+	/* If it's gone already, the child watch will tell */
+	helper->writer = NULL;
+}
+
+static gboolean
+helper_quit_timeout_cb (gpointer user_data)
+{
+	Helper *helper = user_data;
+
+	helper->timeout_id = 0;
+	g_ptr_array_remove (helper->pool->quitting, helper);
+	helper_free (helper);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+helper_idle_timeout_cb (gpointer user_data)
+{
+	Helper *helper = user_data;
+	AuthDialogPool *pool = helper->pool;
+
+	helper->timeout_id = 0;
+	g_ptr_array_remove (pool->helpers, helper);
+	g_ptr_array_add (pool->quitting, helper);
+
+	/* Ask it to quit, with EOF right after, and wait for it to exit */
+	nm_clear_g_source (&helper->channel_eventid);
+	helper->writer = auth_dialog_writer_new (helper->child_stdin, TRUE);
+	helper->child_stdin = -1;
+	auth_dialog_writer_add (helper->writer, "QUIT\n\n", 6);
+	if (!auth_dialog_writer_start (helper->writer, helper_quit_written_cb, helper, NULL))
+		g_clear_pointer (&helper->writer, auth_dialog_writer_free);
+
+	helper->timeout_id = g_timeout_add_seconds (HELPER_QUIT_TIMEOUT_SEC,
+	                                            helper_quit_timeout_cb,
+	                                            helper);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+helper_secret_cb (const char *name, const char *value, gpointer user_data)
+{
+	Helper *helper = user_data;
+
+	nm_assert (helper->current);
+
+	helper->current->secret_func (name, value, helper->current->user_data);
+}
+
+static gboolean
+helper_process_response (Helper *helper, const char *data, gsize len)
+{
+	while (len > 0) {
+		AuthDialogJob *job = helper->current;
+		UtilsSecretsParserResult result;
+		gs_free_error GError *error = NULL;
+		gsize consumed;
+
+		if (!job) {
+			error = g_error_new_literal (NM_SECRET_AGENT_ERROR,
+			                             NM_SECRET_AGENT_ERROR_FAILED,
+			                             "Unexpected response from VPN authentication helper");
+			helper_drop (helper, error);
+			return FALSE;
+		}
+
+		result = utils_secrets_parser_feed (helper->parser, data, len, &consumed);
+		data += consumed;
+		len -= consumed;
+		if (result == UTILS_SECRETS_PARSER_MORE)
+			break;
+
+		utils_secrets_parser_reset (helper->parser);
+		helper->current = NULL;
+		job->helper = NULL;
+		pool_schedule_dispatch (helper->pool);
+
+		switch (result) {
+		case UTILS_SECRETS_PARSER_DONE:
+			job_complete (job, NULL);
+			break;
+		case UTILS_SECRETS_PARSER_CANCELED:
+			error = g_error_new (NM_SECRET_AGENT_ERROR,
+			                     NM_SECRET_AGENT_ERROR_USER_CANCELED,
+			                     "%s.%d (%s): canceled", __FILE__, __LINE__, __func__);
+			job_complete (job, error);
+			break;
+		default:
+			error = g_error_new_literal (NM_SECRET_AGENT_ERROR,
+			                             NM_SECRET_AGENT_ERROR_FAILED,
+			                             "Invalid response from VPN authentication helper");
+			job_complete (job, error);
+			helper_drop (helper, NULL);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+helper_stdout_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	Helper *helper = user_data;
+	GIOStatus status;
+	char buf[4096];
+	gsize bytes_read;
+	gs_free_error GError *error = NULL;
+
+	status = g_io_channel_read_chars (source, buf, sizeof (buf), &bytes_read, &error);
+	switch (status) {
+	case G_IO_STATUS_ERROR:
+		helper->channel_eventid = 0;
+		helper_drop (helper, error);
+		return G_SOURCE_REMOVE;
+	case G_IO_STATUS_EOF:
+		helper->channel_eventid = 0;
+		error = g_error_new_literal (NM_SECRET_AGENT_ERROR,
+		                             NM_SECRET_AGENT_ERROR_FAILED,
+		                             "VPN authentication helper exited unexpectedly");
+		helper_drop (helper, error);
+		return G_SOURCE_REMOVE;
+	case G_IO_STATUS_NORMAL:
+		break;
+	case G_IO_STATUS_AGAIN:
+		return G_SOURCE_CONTINUE;
+	default:
+		g_return_val_if_reached (FALSE);
+	}
+
+	if (!helper_process_response (helper, buf, bytes_read)) {
+		/* The helper is gone, and so is this source */
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+helper_finished_cb (GPid pid, int status, gpointer user_data)
+{
+	Helper *helper = user_data;
+	gs_free_error GError *error = NULL;
+
+	helper->pid = 0;
+	helper->watch_id = 0;
+
+	if (g_ptr_array_remove (helper->pool->quitting, helper)) {
+		helper_free (helper);
+		return;
+	}
+
+	error = g_error_new (NM_SECRET_AGENT_ERROR,
+	                     NM_SECRET_AGENT_ERROR_FAILED,
+	                     "VPN authentication helper exited with status %d", status);
+	helper_drop (helper, error);
+}
+
+static Helper *
+helper_new (AuthDialogPool *pool, GError **error)
+{
+	Helper *helper;
+	GPid pid;
+	int child_stdin, child_stdout;
+
+	if (!auth_dialog_spawn_argv ((const char *const*) pool->argv,
+	                             &pid, &child_stdin, &child_stdout, error))
+		return NULL;
+
+	helper = g_slice_new0 (Helper);
+	helper->pool = pool;
+	helper->pid = pid;
+	helper->child_stdin = child_stdin;
+	helper->parser = utils_secrets_parser_new (TRUE, helper_secret_cb, helper);
+
+	helper->watch_id = g_child_watch_add (pid, helper_finished_cb, helper);
+
+	helper->channel = g_io_channel_unix_new (child_stdout);
+	g_io_channel_set_close_on_unref (helper->channel, TRUE);
+	g_io_channel_set_encoding (helper->channel, NULL, NULL);
+	/* Take whatever is there; the helper doesn't close stdout in between */
+	g_io_channel_set_buffered (helper->channel, FALSE);
+	helper->channel_eventid = g_io_add_watch (helper->channel,
+	                                          G_IO_IN | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
+	                                          helper_stdout_cb,
+	                                          helper);
+
+	g_ptr_array_add (pool->helpers, helper);
+	return helper;
+}
+
+static void
+helper_start_job (Helper *helper, AuthDialogJob *job)
+{
+	AuthDialogWriter *writer;
+	gs_free_error GError *error = NULL;
+
+	nm_clear_g_source (&helper->timeout_id);
+
+	writer = auth_dialog_writer_new (helper->child_stdin, FALSE);
+	if (!job->write_func (writer, job->user_data, &error)) {
+		auth_dialog_writer_free (writer);
+		job_complete (job, error);
+		return;
+	}
+
+	helper->current = job;
+	job->helper = helper;
+
+	if (!auth_dialog_writer_start (writer, helper_written_cb, helper, &error)) {
+		auth_dialog_writer_free (writer);
+		helper_drop (helper, error);
+		return;
+	}
+	helper->writer = writer;
+}
+
+/* Returns an idle helper, spawning one if the pool has room for it. */
+static Helper *
+pool_get_idle_helper (AuthDialogPool *pool, GError **error)
+{
+	guint i;
+
+	for (i = 0; i < pool->helpers->len; i++) {
+		Helper *helper = pool->helpers->pdata[i];
+
+		if (!helper->current && !helper->writer)
+			return helper;
+	}
+
+	if (pool->max_helpers && pool->helpers->len >= pool->max_helpers)
+		return NULL;
+
+	return helper_new (pool, error);
+}
+
+static gboolean
+pool_dispatch_cb (gpointer user_data)
+{
+	AuthDialogPool *pool = user_data;
+	AuthDialogJob *job;
+	guint i;
+
+	pool->dispatch_id = 0;
+
+	while (!g_queue_is_empty (&pool->queue)) {
+		gs_free_error GError *error = NULL;
+		Helper *helper;
+
+		helper = pool_get_idle_helper (pool, &error);
+		if (!helper) {
+			GQueue failed;
+
+			if (!error)
+				break;
+
+			/* Can't start a helper, so nothing queued is going anywhere */
+			failed = pool->queue;
+			g_queue_init (&pool->queue);
+			while ((job = g_queue_pop_head (&failed)))
+				job_complete (job, error);
+			break;
+		}
+
+		job = g_queue_pop_head (&pool->queue);
+		helper_start_job (helper, job);
+	}
+
+	/* Let idle helpers go if they stay that way */
+	for (i = 0; i < pool->helpers->len; i++) {
+		Helper *helper = pool->helpers->pdata[i];
+
+		if (!helper->current && !helper->writer && !helper->timeout_id) {
+			helper->timeout_id = g_timeout_add (pool->idle_timeout_ms,
+			                                    helper_idle_timeout_cb,
+			                                    helper);
+		}
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+pool_schedule_dispatch (AuthDialogPool *pool)
+{
+	if (!pool->dispatch_id)
+		pool->dispatch_id = g_idle_add (pool_dispatch_cb, pool);
+}
+
+AuthDialogPool *
+auth_dialog_pool_new (const char *const*argv,
+                      guint max_helpers,
+                      guint idle_timeout_ms)
+{
+	AuthDialogPool *pool;
+
+	g_return_val_if_fail (argv && argv[0], NULL);
+
+	pool = g_slice_new0 (AuthDialogPool);
+	pool->argv = g_strdupv ((char **) argv);
+	pool->max_helpers = max_helpers;
+	pool->idle_timeout_ms = idle_timeout_ms;
+	pool->helpers = g_ptr_array_new ();
+	pool->quitting = g_ptr_array_new ();
+	g_queue_init (&pool->queue);
+	return pool;
+}
+
+/*
+ * auth_dialog_pool_free
+ *
+ * Kills all helpers and drops any jobs without calling their callbacks.
+ * Must not be called from a job callback.
+ */
+void
+auth_dialog_pool_free (AuthDialogPool *pool)
+{
+	AuthDialogJob *job;
+	guint i;
+
+	if (!pool)
+		return;
+
+	while ((job = g_queue_pop_head (&pool->queue)))
+		g_slice_free (AuthDialogJob, job);
+
+	for (i = 0; i < pool->helpers->len; i++) {
+		Helper *helper = pool->helpers->pdata[i];
+
+		if (helper->current)
+			g_slice_free (AuthDialogJob, helper->current);
+		helper_free (helper);
+	}
+	for (i = 0; i < pool->quitting->len; i++)
+		helper_free (pool->quitting->pdata[i]);
+
+	nm_clear_g_source (&pool->dispatch_id);
+	g_ptr_array_unref (pool->helpers);
+	g_ptr_array_unref (pool->quitting);
+	g_strfreev (pool->argv);
+	g_slice_free (AuthDialogPool, pool);
+}
+
+/*
+ * auth_dialog_pool_submit
+ *
+ * Queues a job.  Once a helper is free, @write_func is called to write the
+ * request to it, @secret_func for each secret in the answer, and finally
+ * @done_func with %NULL or the error, after which the job is gone.  If
+ * @write_func fails, @done_func gets its error.
+ *
+ * Returns: the job, which is valid until @done_func is called.
+ */
+AuthDialogJob *
+auth_dialog_pool_submit (AuthDialogPool *pool,
+                         AuthDialogJobWriteFunc write_func,
+                         AuthDialogJobSecretFunc secret_func,
+                         AuthDialogJobDoneFunc done_func,
+                         gpointer user_data)
+{
+	AuthDialogJob *job;
+
+	g_return_val_if_fail (pool, NULL);
+	g_return_val_if_fail (write_func && secret_func && done_func, NULL);
+
+	job = g_slice_new0 (AuthDialogJob);
+	job->write_func = write_func;
+	job->secret_func = secret_func;
+	job->done_func = done_func;
+	job->user_data = user_data;
+
+	g_queue_push_tail (&pool->queue, job);
+	pool_schedule_dispatch (pool);
+	return job;
+}
+
+/*
+ * auth_dialog_pool_cancel
+ *
+ * Drops a job without calling its done function.  A helper that is serving
+ * the job may still be showing a dialog for it, so it gets killed, like
+ * an auth-dialog spawned for a single request.
+ */
+void
+auth_dialog_pool_cancel (AuthDialogPool *pool, AuthDialogJob *job)
+{
+	Helper *helper;
+
+	g_return_if_fail (pool);
+	g_return_if_fail (job);
+
+	helper = job->helper;
+	if (helper) {
+		helper->current = NULL;
+		g_ptr_array_remove (pool->helpers, helper);
+		helper_free (helper);
+		pool_schedule_dispatch (pool);
+	} else
+		g_queue_remove (&pool->queue, job);
+
+	g_slice_free (AuthDialogJob, job);
+}
+
+/* Counts the running helpers, including the ones that are quitting. */
+guint
+auth_dialog_pool_get_n_helpers (AuthDialogPool *pool)
+{
+	g_return_val_if_fail (pool, 0);
+
+	return pool->helpers->len + pool->quitting->len;
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0+
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * Copyright 2026 Red Hat, Inc.
+ */
+
+#ifndef AUTH_DIALOG_H
+#define AUTH_DIALOG_H
+
+typedef struct _AuthDialogWriter AuthDialogWriter;
+
+typedef void (*AuthDialogWriterDoneFunc) (GError *error, gpointer user_data);
+
+AuthDialogWriter *auth_dialog_writer_new (int fd, gboolean close_fd);
+
+void auth_dialog_writer_free (AuthDialogWriter *writer);
+
+void auth_dialog_writer_add (AuthDialogWriter *writer,
+                             const char *data,
+                             gsize len);
+
+void auth_dialog_writer_take (AuthDialogWriter *writer, char *str);
+
+void auth_dialog_writer_hold (AuthDialogWriter *writer, gpointer object);
+
+void auth_dialog_writer_add_value (AuthDialogWriter *writer,
+                                   const char *tag,
+                                   const char *val);
+
+void auth_dialog_writer_take_value (AuthDialogWriter *writer,
+                                    const char *tag,
+                                    char *val);
+
+gboolean auth_dialog_writer_start (AuthDialogWriter *writer,
+                                   AuthDialogWriterDoneFunc func,
+                                   gpointer user_data,
+                                   GError **error);
+
+gboolean auth_dialog_spawn_argv (const char *const*argv,
+                                 GPid *out_pid,
+                                 int *out_stdin,
+                                 int *out_stdout,
+                                 GError **error);
+
+void auth_dialog_kill (GPid pid);
+
+void auth_dialog_release (GPid pid, guint timeout_sec);
+
+typedef struct _AuthDialogPool AuthDialogPool;
+typedef struct _AuthDialogJob AuthDialogJob;
+
+typedef gboolean (*AuthDialogJobWriteFunc) (AuthDialogWriter *writer,
+                                            gpointer user_data,
+                                            GError **error);
+
+typedef void (*AuthDialogJobSecretFunc) (const char *name,
+                                         const char *value,
+                                         gpointer user_data);
+
+typedef void (*AuthDialogJobDoneFunc) (GError *error, gpointer user_data);
+
+AuthDialogPool *auth_dialog_pool_new (const char *const*argv,
+                                      guint max_helpers,
+                                      guint idle_timeout_ms);
+
+void auth_dialog_pool_free (AuthDialogPool *pool);
+
+AuthDialogJob *auth_dialog_pool_submit (AuthDialogPool *pool,
+                                        AuthDialogJobWriteFunc write_func,
+                                        AuthDialogJobSecretFunc secret_func,
+                                        AuthDialogJobDoneFunc done_func,
+                                        gpointer user_data);
+
+void auth_dialog_pool_cancel (AuthDialogPool *pool, AuthDialogJob *job);
+
+guint auth_dialog_pool_get_n_helpers (AuthDialogPool *pool);
+
+#endif /* AUTH_DIALOG_H */
@@ -9,8 +9,15 @@
 #include "nm-default.h"
 
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <glib-unix.h>
 
 #include "utils.h"
+#include "auth-dialog.h"
 
 #include "nm-utils/nm-test-utils.h"
 
@@ -397,6 +404,1162 @@ test_ap_hash_foobar_asdf11_adhoc_wpa_rsn (TestData *d)
 	g_assert (strcmp (d->foobar_adhoc_wpa_rsn, d->asdf11_adhoc_wpa_rsn));
 }
 
+typedef struct {
+	const char *ssid;
+	gsize ssid_len;
+	NM80211Mode mode;
+	guint32 flags;
+	guint32 wpa_flags;
+	guint32 rsn_flags;
+} ApKeyCase;
+
+#define WPA_PSK (NM_802_11_AP_SEC_PAIR_TKIP | NM_802_11_AP_SEC_GROUP_TKIP | NM_802_11_AP_SEC_KEY_MGMT_PSK)
+#define RSN_PSK (NM_802_11_AP_SEC_PAIR_CCMP | NM_802_11_AP_SEC_GROUP_CCMP | NM_802_11_AP_SEC_KEY_MGMT_PSK)
+
+static const ApKeyCase ap_key_cases[] = {
+	{ "foobar", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE,    NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "foobar", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_PRIVACY, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "foobar", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_PRIVACY, WPA_PSK,               NM_802_11_AP_SEC_NONE },
+	{ "foobar", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_PRIVACY, NM_802_11_AP_SEC_NONE, RSN_PSK },
+	{ "foobar", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_PRIVACY, WPA_PSK,               RSN_PSK },
+	{ "foobar", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE,    WPA_PSK,               RSN_PSK },
+	{ "foobar", 6, NM_802_11_MODE_ADHOC, NM_802_11_AP_FLAGS_NONE,    NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "foobar", 6, NM_802_11_MODE_ADHOC, NM_802_11_AP_FLAGS_PRIVACY, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "foobar", 6, NM_802_11_MODE_ADHOC, NM_802_11_AP_FLAGS_PRIVACY, WPA_PSK,               NM_802_11_AP_SEC_NONE },
+	{ "foobar", 6, NM_802_11_MODE_ADHOC, NM_802_11_AP_FLAGS_PRIVACY, NM_802_11_AP_SEC_NONE, RSN_PSK },
+	{ "foobar", 6, NM_802_11_MODE_ADHOC, NM_802_11_AP_FLAGS_PRIVACY, WPA_PSK,               RSN_PSK },
+	{ "foobar", 6, NM_802_11_MODE_AP,    NM_802_11_AP_FLAGS_NONE,    NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "asdf11", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE,    NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "asdf11", 6, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_PRIVACY, WPA_PSK,               RSN_PSK },
+	{ "asdf11", 6, NM_802_11_MODE_ADHOC, NM_802_11_AP_FLAGS_PRIVACY, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	/* trailing NUL bytes are not significant, as the SSID gets zero-padded */
+	{ "foobar\0", 7, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "", 0, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "0123456789abcdef0123456789abcdef", 32, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+	{ "0123456789abcdef0123456789abcdeF", 32, NM_802_11_MODE_INFRA, NM_802_11_AP_FLAGS_NONE, NM_802_11_AP_SEC_NONE, NM_802_11_AP_SEC_NONE },
+};
+
+/* The binary key must group APs exactly like the MD5 hash does */
+static void
+test_ap_key_equivalence (void)
+{
+	char *hashes[G_N_ELEMENTS (ap_key_cases)];
+	UtilsApKey keys[G_N_ELEMENTS (ap_key_cases)];
+	guint i, j;
+
+	for (i = 0; i < G_N_ELEMENTS (ap_key_cases); i++) {
+		const ApKeyCase *c = &ap_key_cases[i];
+		GBytes *ssid;
+		UtilsApKey key2;
+
+		ssid = g_bytes_new (c->ssid, c->ssid_len);
+		hashes[i] = utils_hash_ap (ssid, c->mode, c->flags, c->wpa_flags, c->rsn_flags);
+		utils_ap_key_init (&keys[i], ssid, c->mode, c->flags, c->wpa_flags, c->rsn_flags);
+
+		/* Make sure they are the same each time */
+		utils_ap_key_init (&key2, ssid, c->mode, c->flags, c->wpa_flags, c->rsn_flags);
+		g_assert (utils_ap_key_equal (&keys[i], &key2));
+		g_assert_cmpuint (utils_ap_key_hash (&keys[i]), ==, utils_ap_key_hash (&key2));
+
+		g_bytes_unref (ssid);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (ap_key_cases); i++) {
+		for (j = 0; j < G_N_ELEMENTS (ap_key_cases); j++) {
+			gboolean same_hash = !strcmp (hashes[i], hashes[j]);
+
+			if (same_hash != utils_ap_key_equal (&keys[i], &keys[j]))
+				g_error ("case %u and %u: hashes %s, keys %s", i, j,
+				         same_hash ? "equal" : "differ",
+				         same_hash ? "differ" : "equal");
+		}
+	}
+
+	/* Spot-check the grouping itself */
+	g_assert (utils_ap_key_equal (&keys[2], &keys[3]));
+	g_assert (utils_ap_key_equal (&keys[2], &keys[4]));
+	g_assert (!utils_ap_key_equal (&keys[0], &keys[1]));
+	g_assert (!utils_ap_key_equal (&keys[0], &keys[6]));
+	g_assert (!utils_ap_key_equal (&keys[0], &keys[12]));
+	g_assert (utils_ap_key_equal (&keys[0], &keys[15]));
+	g_assert (!utils_ap_key_equal (&keys[17], &keys[18]));
+
+	for (i = 0; i < G_N_ELEMENTS (ap_key_cases); i++)
+		g_free (hashes[i]);
+}
+
+typedef struct {
+	GBytes *ssid;
+	gboolean secure;
+	guint8 strength;
+} TestAp;
+
+typedef struct {
+	const TestAp *first;
+	guint n_aps;
+	guint8 strength;
+} TestApGroup;
+
+static gpointer
+test_ap_group_new (gpointer ap, const UtilsApKey *key, gpointer user_data)
+{
+	TestApGroup *group;
+
+	group = g_slice_new0 (TestApGroup);
+	group->first = ap;
+	group->n_aps = 1;
+	group->strength = group->first->strength;
+	return group;
+}
+
+static void
+test_ap_group_add (gpointer group, gpointer ap, gpointer user_data)
+{
+	TestApGroup *g = group;
+
+	g->n_aps++;
+	g->strength = MAX (g->strength, ((TestAp *) ap)->strength);
+}
+
+static void
+test_ap_group_free (gpointer group)
+{
+	g_slice_free (TestApGroup, group);
+}
+
+static gint
+test_ap_group_compare (gconstpointer a, gconstpointer b)
+{
+	const TestApGroup *ga = a, *gb = b;
+
+	if (ga->first->secure != gb->first->secure)
+		return ga->first->secure ? -1 : 1;
+	return g_bytes_compare (ga->first->ssid, gb->first->ssid);
+}
+
+/* Feeds a synthetic scan list through utils_ap_groups_add(), which is what
+ * get_menu_item_for_ap() uses to fold the BSSs of one network into a single
+ * menu item, the same way wifi_add_menu_item() does: one pass over the scan
+ * list collecting the new groups, followed by a sort.  Only creating the
+ * menu items themselves is stubbed out.
+ * Run with "-m perf" to get timings for several rounds.
+ */
+static void
+test_ap_hash_grouping (gconstpointer user_data)
+{
+	guint n_aps = GPOINTER_TO_UINT (user_data);
+	guint n_networks = MAX (n_aps / 10, 1);
+	guint rounds = g_test_perf () ? 100 : 1;
+	TestAp *aps;
+	GHashTable *groups = NULL;
+	GSList *list = NULL, *iter;
+	gdouble elapsed;
+	guint i, r, total;
+
+	aps = g_new0 (TestAp, n_aps);
+	for (i = 0; i < n_aps; i++) {
+		char buf[32];
+
+		g_snprintf (buf, sizeof (buf), "network-%u", i % n_networks);
+		aps[i].ssid = string_to_ssid (buf);
+		aps[i].secure = (i / n_networks) % 2;
+		aps[i].strength = g_test_rand_int_range (0, 101);
+	}
+
+	g_test_timer_start ();
+	for (r = 0; r < rounds; r++) {
+		g_clear_pointer (&list, g_slist_free);
+		g_clear_pointer (&groups, g_hash_table_destroy);
+		groups = utils_ap_groups_new (test_ap_group_free);
+
+		for (i = 0; i < n_aps; i++) {
+			UtilsApKey key;
+			gpointer group;
+
+			utils_ap_key_init (&key,
+			                   aps[i].ssid,
+			                   NM_802_11_MODE_INFRA,
+			                   aps[i].secure ? NM_802_11_AP_FLAGS_PRIVACY : NM_802_11_AP_FLAGS_NONE,
+			                   NM_802_11_AP_SEC_NONE,
+			                   aps[i].secure ? NM_802_11_AP_SEC_KEY_MGMT_PSK : NM_802_11_AP_SEC_NONE);
+			group = utils_ap_groups_add (groups, &aps[i], &key,
+			                             test_ap_group_new, test_ap_group_add, NULL);
+			if (group)
+				list = g_slist_prepend (list, group);
+		}
+		list = g_slist_reverse (list);
+		list = g_slist_sort (list, test_ap_group_compare);
+	}
+	elapsed = g_test_timer_elapsed ();
+
+	/* Every network shows up once open and once secured */
+	g_assert_cmpuint (g_hash_table_size (groups), ==, MIN (n_aps, n_networks * 2));
+	g_assert_cmpuint (g_slist_length (list), ==, g_hash_table_size (groups));
+
+	total = 0;
+	for (iter = list; iter; iter = iter->next) {
+		TestApGroup *group = iter->data;
+
+		if (iter->next)
+			g_assert_cmpint (test_ap_group_compare (group, iter->next->data), <, 0);
+		total += group->n_aps;
+	}
+	g_assert_cmpuint (total, ==, n_aps);
+
+	if (g_test_perf ())
+		g_test_minimized_result (elapsed / rounds, "grouping %u APs: %.3f us", n_aps, elapsed * 1e6 / rounds);
+
+	g_slist_free (list);
+	g_hash_table_destroy (groups);
+	for (i = 0; i < n_aps; i++)
+		g_bytes_unref (aps[i].ssid);
+	g_free (aps);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	gboolean with_status;
+	const char *response;
+	UtilsSecretsParserResult result;
+	const char *secrets;
+	const char *rest;
+} SecretsParserCase;
+
+static const SecretsParserCase secrets_parser_cases[] = {
+	{ FALSE, "foo\nbar\nbaz\nqux\n\n",        UTILS_SECRETS_PARSER_DONE,     "foo=bar;baz=qux;", "" },
+	{ FALSE, "foo\nbar\n\nQUIT\n",            UTILS_SECRETS_PARSER_DONE,     "foo=bar;",         "QUIT\n" },
+	{ FALSE, "foo\n\nbar\nbaz\n\n",           UTILS_SECRETS_PARSER_DONE,     "foo=;bar=baz;",    "" },
+	{ FALSE, "\n",                            UTILS_SECRETS_PARSER_DONE,     "",                 "" },
+	{ FALSE, "foo\nbar\nbaz",                 UTILS_SECRETS_PARSER_DONE,     "foo=bar;",         "" },
+	{ FALSE, "foo\nbar",                      UTILS_SECRETS_PARSER_DONE,     "foo=bar;",         "" },
+	{ FALSE, "",                              UTILS_SECRETS_PARSER_DONE,     "",                 "" },
+	{ TRUE,  "OK\nfoo\nbar\n\nOK\n",          UTILS_SECRETS_PARSER_DONE,     "foo=bar;",         "OK\n" },
+	{ TRUE,  "OK\n\n",                        UTILS_SECRETS_PARSER_DONE,     "",                 "" },
+	{ TRUE,  "CANCEL\nfoo\nbar\n",            UTILS_SECRETS_PARSER_CANCELED, "",                 "foo\nbar\n" },
+	{ TRUE,  "foo\nbar\n\n",                  UTILS_SECRETS_PARSER_ERROR,    "",                 "bar\n\n" },
+	{ TRUE,  "OK\nfoo\nbar",                  UTILS_SECRETS_PARSER_DONE,     "foo=bar;",         "" },
+	{ TRUE,  "OK",                            UTILS_SECRETS_PARSER_DONE,     "",                 "" },
+	{ TRUE,  "",                              UTILS_SECRETS_PARSER_ERROR,    "",                 "" },
+};
+
+static void
+secrets_parser_cb (const char *name, const char *value, gpointer user_data)
+{
+	g_string_append_printf (user_data, "%s=%s;", name, value);
+}
+
+/* Feeds @c->response to a parser in chunks that end at @splits, and checks
+ * that the outcome doesn't depend on where the input was split. */
+static void
+secrets_parser_check (const SecretsParserCase *c, const gsize *splits, guint n_splits)
+{
+	UtilsSecretsParser *parser;
+	UtilsSecretsParserResult result = UTILS_SECRETS_PARSER_MORE;
+	GString *secrets;
+	gsize len = strlen (c->response);
+	gsize pos = 0;
+	gsize consumed;
+	guint i;
+
+	secrets = g_string_new (NULL);
+	parser = utils_secrets_parser_new (c->with_status, secrets_parser_cb, secrets);
+
+	for (i = 0; i <= n_splits && result == UTILS_SECRETS_PARSER_MORE; i++) {
+		gsize end = i < n_splits ? splits[i] : len;
+
+		g_assert_cmpuint (end, >=, pos);
+		result = utils_secrets_parser_feed (parser, c->response + pos, end - pos, &consumed);
+		if (result == UTILS_SECRETS_PARSER_MORE)
+			g_assert_cmpuint (consumed, ==, end - pos);
+		pos += consumed;
+	}
+	if (result == UTILS_SECRETS_PARSER_MORE) {
+		g_assert_cmpuint (pos, ==, len);
+		result = utils_secrets_parser_finish (parser);
+	}
+
+	g_assert_cmpint (result, ==, c->result);
+	g_assert_cmpstr (secrets->str, ==, c->secrets);
+	if (c->result != UTILS_SECRETS_PARSER_ERROR)
+		g_assert_cmpstr (c->response + pos, ==, c->rest);
+
+	/* Once done, more input is left alone */
+	g_assert_cmpint (utils_secrets_parser_feed (parser, "x\ny\n", 4, &consumed), ==, c->result);
+	g_assert_cmpuint (consumed, ==, 0);
+
+	utils_secrets_parser_free (parser);
+	g_string_free (secrets, TRUE);
+}
+
+static void
+test_secrets_parser_splits (void)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (secrets_parser_cases); i++) {
+		const SecretsParserCase *c = &secrets_parser_cases[i];
+		gsize len = strlen (c->response);
+		gsize splits[2];
+
+		/* In one piece, and split once or twice at every possible place */
+		secrets_parser_check (c, NULL, 0);
+		for (splits[0] = 0; splits[0] <= len; splits[0]++) {
+			secrets_parser_check (c, splits, 1);
+			for (splits[1] = splits[0]; splits[1] <= len; splits[1]++)
+				secrets_parser_check (c, splits, 2);
+		}
+	}
+}
+
+static void
+test_secrets_parser_random (void)
+{
+	guint i, r;
+
+	for (i = 0; i < G_N_ELEMENTS (secrets_parser_cases); i++) {
+		const SecretsParserCase *c = &secrets_parser_cases[i];
+		gsize len = strlen (c->response);
+		gs_free gsize *splits = g_new (gsize, len + 1);
+
+		for (r = 0; r < 100; r++) {
+			guint n_splits = 0;
+			gsize pos = 0;
+
+			/* Random chunks, including empty ones */
+			while (pos < len) {
+				pos = MIN (len, pos + g_test_rand_int_range (0, 4));
+				splits[n_splits++] = pos;
+				if (n_splits > len)
+					break;
+			}
+			secrets_parser_check (c, splits, n_splits);
+		}
+	}
+}
+
+/* A long response read in small chunks, so that values straddle many
+ * chunk boundaries. */
+static void
+test_secrets_parser_long (void)
+{
+	UtilsSecretsParser *parser;
+	GString *response, *expected, *secrets;
+	UtilsSecretsParserResult result = UTILS_SECRETS_PARSER_MORE;
+	gsize pos, consumed;
+	guint i;
+
+	response = g_string_new (NULL);
+	expected = g_string_new (NULL);
+	for (i = 0; i < 200; i++) {
+		gs_free char *value = g_strnfill (i * 7, 'a' + (i % 26));
+
+		g_string_append_printf (response, "key%u\n%s\n", i, value);
+		g_string_append_printf (expected, "key%u=%s;", i, value);
+	}
+	g_string_append (response, "\n");
+
+	secrets = g_string_new (NULL);
+	parser = utils_secrets_parser_new (FALSE, secrets_parser_cb, secrets);
+	for (pos = 0; pos < response->len && result == UTILS_SECRETS_PARSER_MORE; pos += consumed) {
+		result = utils_secrets_parser_feed (parser,
+		                                    response->str + pos,
+		                                    MIN (13, response->len - pos),
+		                                    &consumed);
+	}
+
+	g_assert_cmpint (result, ==, UTILS_SECRETS_PARSER_DONE);
+	g_assert_cmpuint (pos, ==, response->len);
+	g_assert_cmpstr (secrets->str, ==, expected->str);
+
+	utils_secrets_parser_free (parser);
+	g_string_free (secrets, TRUE);
+	g_string_free (expected, TRUE);
+	g_string_free (response, TRUE);
+}
+
+/*****************************************************************************/
+
+/* Stands in for the connection list: rows keyed by synthetic connection
+ * objects, and a refilter that looks at every row, the way
+ * gtk_tree_model_filter_refilter() does. */
+typedef struct {
+	UtilsBatch *refilter;
+	GHashTable *rows;
+	guint n_checks;
+} BatchTest;
+
+static void
+batch_test_refilter_cb (gpointer user_data)
+{
+	BatchTest *t = user_data;
+
+	t->n_checks += g_hash_table_size (t->rows);
+}
+
+static void
+batch_test_add_rows (BatchTest *t, guint n)
+{
+	guint i;
+
+	for (i = 0; i < n; i++) {
+		g_hash_table_add (t->rows, g_object_new (G_TYPE_OBJECT, NULL));
+		utils_batch_schedule (t->refilter);
+	}
+}
+
+static void
+batch_test_remove_rows (BatchTest *t, guint n)
+{
+	GHashTableIter iter;
+
+	g_hash_table_iter_init (&iter, t->rows);
+	while (n-- && g_hash_table_iter_next (&iter, NULL, NULL)) {
+		g_hash_table_iter_remove (&iter);
+		utils_batch_schedule (t->refilter);
+	}
+}
+
+static void
+test_main_loop_iterate (void)
+{
+	while (g_main_context_iteration (NULL, FALSE))
+		;
+}
+
+/* Thousands of connections showing up at once, as when the editor starts
+ * or NetworkManager reloads them, cause one refilter, not one each. */
+static void
+test_batch_refilter (gconstpointer user_data)
+{
+	guint n_rows = GPOINTER_TO_UINT (user_data);
+	BatchTest t = { 0 };
+	guint i;
+
+	t.refilter = utils_batch_new (batch_test_refilter_cb, &t);
+	t.rows = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+
+	batch_test_add_rows (&t, n_rows);
+	g_assert_cmpuint (utils_batch_get_n_runs (t.refilter), ==, 0);
+	test_main_loop_iterate ();
+	g_assert_cmpuint (utils_batch_get_n_runs (t.refilter), ==, 1);
+	g_assert_cmpuint (t.n_checks, ==, n_rows);
+
+	/* Removals and changes within an iteration share one refilter too */
+	t.n_checks = 0;
+	batch_test_remove_rows (&t, n_rows / 2);
+	for (i = 0; i < n_rows / 4; i++)
+		utils_batch_schedule (t.refilter);
+	test_main_loop_iterate ();
+	g_assert_cmpuint (utils_batch_get_n_runs (t.refilter), ==, 2);
+	g_assert_cmpuint (t.n_checks, ==, n_rows - n_rows / 2);
+
+	/* Changes in separate iterations each get theirs */
+	for (i = 0; i < 3; i++) {
+		batch_test_add_rows (&t, 1);
+		test_main_loop_iterate ();
+	}
+	g_assert_cmpuint (utils_batch_get_n_runs (t.refilter), ==, 5);
+
+	/* Refiltering right away takes the place of the pending refilter */
+	batch_test_add_rows (&t, 10);
+	utils_batch_run_now (t.refilter);
+	test_main_loop_iterate ();
+	g_assert_cmpuint (utils_batch_get_n_runs (t.refilter), ==, 6);
+
+	/* Nothing runs after the batch is gone */
+	batch_test_add_rows (&t, 1);
+	utils_batch_free (t.refilter);
+	test_main_loop_iterate ();
+
+	g_hash_table_destroy (t.rows);
+}
+
+/*****************************************************************************/
+
+static gboolean
+test_timeout_cb (gpointer user_data)
+{
+	g_error ("Test timed out");
+	return G_SOURCE_REMOVE;
+}
+
+static void
+test_run_loop (GMainLoop *loop)
+{
+	guint id;
+
+	id = g_timeout_add_seconds (20, test_timeout_cb, NULL);
+	g_main_loop_run (loop);
+	g_source_remove (id);
+}
+
+typedef struct {
+	GMainLoop *loop;
+	GString *received;
+	gsize chunk;
+	guint reads;
+	gboolean eof;
+	gboolean done;
+	GError *error;
+} WriterTest;
+
+static void
+writer_test_done_cb (GError *error, gpointer user_data)
+{
+	WriterTest *t = user_data;
+
+	g_assert (!t->done);
+	t->done = TRUE;
+	if (error)
+		t->error = g_error_copy (error);
+	if (t->eof)
+		g_main_loop_quit (t->loop);
+}
+
+/* Reads in small odd-sized chunks, so that the writer keeps finding the
+ * pipe full. */
+static gboolean
+writer_test_read_cb (int fd, GIOCondition condition, gpointer user_data)
+{
+	WriterTest *t = user_data;
+	char buf[4096];
+	gssize r;
+
+	r = read (fd, buf, t->chunk);
+	if (r < 0 && errno == EAGAIN)
+		return G_SOURCE_CONTINUE;
+	g_assert_cmpint (r, >=, 0);
+
+	t->reads++;
+	if (r > 0) {
+		g_string_append_len (t->received, buf, r);
+		return G_SOURCE_CONTINUE;
+	}
+
+	t->eof = TRUE;
+	if (t->done)
+		g_main_loop_quit (t->loop);
+	return G_SOURCE_REMOVE;
+}
+
+/* Writes about a megabyte spread over several times IOV_MAX iovecs into a
+ * small pipe. Large iovecs get split by partial writes, and the writer has
+ * to wait for the reader every few kilobytes. */
+static void
+test_auth_dialog_writer_pipe (void)
+{
+	AuthDialogWriter *writer;
+	WriterTest t = { 0 };
+	GString *expected;
+	gs_free char *big = NULL;
+	GError *error = NULL;
+	int fds[2];
+	guint i;
+
+	if (!g_unix_open_pipe (fds, FD_CLOEXEC, &error))
+		g_assert_no_error (error);
+#ifdef F_SETPIPE_SZ
+	fcntl (fds[1], F_SETPIPE_SZ, 4096);
+#endif
+	g_assert (g_unix_set_fd_nonblocking (fds[0], TRUE, NULL));
+
+	big = g_strnfill (65536 + 7, 'x');
+	expected = g_string_new (NULL);
+	writer = auth_dialog_writer_new (fds[1], TRUE);
+	for (i = 0; i < IOV_MAX * 3; i++) {
+		auth_dialog_writer_take_value (writer, "DATA_KEY", g_strdup_printf ("key%u", i));
+		auth_dialog_writer_take_value (writer, "DATA_VAL", g_strdup_printf ("line %u\nnext\n\nlast", i));
+		g_string_append_printf (expected, "DATA_KEY=key%u\nDATA_VAL=line %u next  last\n", i, i);
+
+		if (i % 200 == 0) {
+			auth_dialog_writer_add (writer, big, 65536 + 7);
+			g_string_append (expected, big);
+		}
+		auth_dialog_writer_add (writer, "", 0);
+	}
+	auth_dialog_writer_add (writer, "DONE\n\n", 6);
+	g_string_append (expected, "DONE\n\n");
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.received = g_string_new (NULL);
+	t.chunk = 777;
+	g_unix_fd_add (fds[0], G_IO_IN | G_IO_HUP, writer_test_read_cb, &t);
+
+	g_assert (auth_dialog_writer_start (writer, writer_test_done_cb, &t, &error));
+	g_assert_no_error (error);
+	test_run_loop (t.loop);
+
+	g_assert (t.done);
+	g_assert_no_error (t.error);
+	g_assert (t.eof);
+	g_assert_cmpuint (t.received->len, ==, expected->len);
+	g_assert (memcmp (t.received->str, expected->str, expected->len) == 0);
+	g_assert_cmpuint (t.reads, >, expected->len / 4096);
+
+	nm_close (fds[0]);
+	g_main_loop_unref (t.loop);
+	g_string_free (t.received, TRUE);
+	g_string_free (expected, TRUE);
+}
+
+/* Values are written from where they are, not from a copy: changing one
+ * before the write shows up in the output. */
+static void
+test_auth_dialog_writer_in_place (void)
+{
+	AuthDialogWriter *writer;
+	WriterTest t = { 0 };
+	gs_free char *val = NULL;
+	GError *error = NULL;
+	int fds[2];
+
+	if (!g_unix_open_pipe (fds, FD_CLOEXEC, &error))
+		g_assert_no_error (error);
+	g_assert (g_unix_set_fd_nonblocking (fds[0], TRUE, NULL));
+
+	val = g_strdup ("-----BEGIN CERTIFICATE-----\nAAAA\n-----END CERTIFICATE-----\n");
+	writer = auth_dialog_writer_new (fds[1], TRUE);
+	auth_dialog_writer_add_value (writer, "DATA_VAL", val);
+	auth_dialog_writer_add (writer, "DONE\n\n", 6);
+	memcpy (strstr (val, "AAAA"), "BBBB", 4);
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.received = g_string_new (NULL);
+	t.chunk = 4096;
+	g_unix_fd_add (fds[0], G_IO_IN | G_IO_HUP, writer_test_read_cb, &t);
+	g_assert (auth_dialog_writer_start (writer, writer_test_done_cb, &t, &error));
+	g_assert_no_error (error);
+	test_run_loop (t.loop);
+
+	g_assert_no_error (t.error);
+	g_assert_cmpstr (t.received->str, ==,
+	                 "DATA_VAL=-----BEGIN CERTIFICATE----- BBBB -----END CERTIFICATE----- \nDONE\n\n");
+
+	nm_close (fds[0]);
+	g_main_loop_unref (t.loop);
+	g_string_free (t.received, TRUE);
+}
+
+/* A reader that went away fails the write instead of hanging it. */
+static void
+test_auth_dialog_writer_epipe (void)
+{
+	AuthDialogWriter *writer;
+	WriterTest t = { 0 };
+	GError *error = NULL;
+	int fds[2];
+
+	if (!g_unix_open_pipe (fds, FD_CLOEXEC, &error))
+		g_assert_no_error (error);
+	nm_close (fds[0]);
+
+	writer = auth_dialog_writer_new (fds[1], TRUE);
+	auth_dialog_writer_add_value (writer, "DATA_KEY", "foo");
+	auth_dialog_writer_add (writer, "DONE\n\n", 6);
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.eof = TRUE;
+	g_assert (auth_dialog_writer_start (writer, writer_test_done_cb, &t, &error));
+	test_run_loop (t.loop);
+
+	g_assert (t.done);
+	g_assert_error (t.error, NM_SECRET_AGENT_ERROR, NM_SECRET_AGENT_ERROR_FAILED);
+
+	g_clear_error (&t.error);
+	g_main_loop_unref (t.loop);
+}
+
+/*****************************************************************************/
+
+/* Stands in for a VPN plugin's auth-dialog. The request name picks what it
+ * does with a request; secrets carry the PID, so that tests can tell which
+ * process served them. Run as "sh <script> persistent|oneshot <log>". */
+static const char fake_auth_dialog[] =
+	"mode=$1\n"
+	"log=$2\n"
+	"name=\n"
+	"while read -r line; do\n"
+	"	case \"$line\" in\n"
+	"	QUIT)\n"
+	"		echo \"quit $$\" >> \"$log\"\n"
+	"		exit 0 ;;\n"
+	"	NAME=*)\n"
+	"		name=${line#NAME=} ;;\n"
+	"	DONE)\n"
+	"		case \"$name\" in\n"
+	"		die)\n"
+	"			exit 3 ;;\n"
+	"		hang)\n"
+	"			;;\n"
+	"		cancel)\n"
+	"			echo \"cancel $$\" >> \"$log\"\n"
+	"			echo CANCEL ;;\n"
+	"		*)\n"
+	"			[ \"$mode\" = persistent ] && echo OK\n"
+	"			printf 'password\\n%s-%s\\n\\n' \"$name\" $$ ;;\n"
+	"		esac ;;\n"
+	"	esac\n"
+	"done\n"
+	"echo \"eof $$\" >> \"$log\"\n";
+
+static char *fake_auth_dialog_path;
+static char *fake_auth_dialog_log;
+
+static void
+fake_auth_dialog_create (void)
+{
+	GError *error = NULL;
+	int fd;
+
+	fd = g_file_open_tmp ("test-auth-dialog-XXXXXX.sh", &fake_auth_dialog_path, &error);
+	g_assert_no_error (error);
+	nm_close (fd);
+	g_file_set_contents (fake_auth_dialog_path, fake_auth_dialog, -1, &error);
+	g_assert_no_error (error);
+
+	fd = g_file_open_tmp ("test-auth-dialog-XXXXXX.log", &fake_auth_dialog_log, &error);
+	g_assert_no_error (error);
+	nm_close (fd);
+}
+
+static void
+fake_auth_dialog_remove (void)
+{
+	unlink (fake_auth_dialog_path);
+	unlink (fake_auth_dialog_log);
+	nm_clear_g_free (&fake_auth_dialog_path);
+	nm_clear_g_free (&fake_auth_dialog_log);
+}
+
+typedef struct {
+	GMainLoop *loop;
+	guint pending;
+	guint completed;
+} PoolTest;
+
+typedef struct {
+	PoolTest *t;
+	const char *name;
+	AuthDialogJob *job;
+	gboolean done;
+	guint order;
+	char *secret;
+	GError *error;
+} PoolTestJob;
+
+static AuthDialogPool *
+pool_test_new (guint max_helpers, guint idle_timeout_ms)
+{
+	const char *argv[] = { "/bin/sh", fake_auth_dialog_path, "persistent", fake_auth_dialog_log, NULL };
+
+	return auth_dialog_pool_new (argv, max_helpers, idle_timeout_ms);
+}
+
+static gboolean
+pool_test_write_cb (AuthDialogWriter *writer, gpointer user_data, GError **error)
+{
+	PoolTestJob *j = user_data;
+
+	auth_dialog_writer_add (writer, "REQUEST\n", 8);
+	auth_dialog_writer_add_value (writer, "NAME", j->name);
+	auth_dialog_writer_add (writer, "DONE\n\n", 6);
+	return TRUE;
+}
+
+static void
+pool_test_secret_cb (const char *name, const char *value, gpointer user_data)
+{
+	PoolTestJob *j = user_data;
+
+	g_assert_cmpstr (name, ==, "password");
+	g_assert (!j->secret);
+	j->secret = g_strdup (value);
+}
+
+static void
+pool_test_done_cb (GError *error, gpointer user_data)
+{
+	PoolTestJob *j = user_data;
+
+	g_assert (!j->done);
+	j->done = TRUE;
+	j->job = NULL;
+	j->order = ++j->t->completed;
+	if (error)
+		j->error = g_error_copy (error);
+
+	g_assert_cmpuint (j->t->pending, >, 0);
+	if (--j->t->pending == 0)
+		g_main_loop_quit (j->t->loop);
+}
+
+static void
+pool_test_submit (AuthDialogPool *pool, PoolTest *t, PoolTestJob *j, const char *name)
+{
+	j->t = t;
+	j->name = name;
+	j->job = auth_dialog_pool_submit (pool,
+	                                  pool_test_write_cb,
+	                                  pool_test_secret_cb,
+	                                  pool_test_done_cb,
+	                                  j);
+}
+
+static void
+pool_test_job_clear (PoolTestJob *j)
+{
+	nm_clear_g_free (&j->secret);
+	g_clear_error (&j->error);
+}
+
+/* The PID of the process that answered */
+static const char *
+pool_test_job_pid (PoolTestJob *j)
+{
+	g_assert (j->secret);
+	return strrchr (j->secret, '-') + 1;
+}
+
+static gboolean
+pool_test_log_has (const char *what, const char *pid)
+{
+	gs_free char *contents = NULL;
+	gs_free char *line = g_strdup_printf ("%s %s\n", what, pid);
+
+	if (!g_file_get_contents (fake_auth_dialog_log, &contents, NULL, NULL))
+		return FALSE;
+	return strstr (contents, line) != NULL;
+}
+
+static gboolean
+pool_test_wait_helpers (AuthDialogPool *pool, guint n_helpers)
+{
+	gint64 end = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+
+	while (auth_dialog_pool_get_n_helpers (pool) != n_helpers) {
+		if (g_get_monotonic_time () > end)
+			return FALSE;
+		g_main_context_iteration (NULL, TRUE);
+	}
+	return TRUE;
+}
+
+/* With a single helper, requests are served one at a time, in order, by
+ * the same process. */
+static void
+test_auth_dialog_pool_queue (void)
+{
+	AuthDialogPool *pool = pool_test_new (1, 60000);
+	PoolTest t = { 0 };
+	PoolTestJob jobs[3] = { { 0 } };
+	guint i;
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.pending = 3;
+	pool_test_submit (pool, &t, &jobs[0], "a");
+	pool_test_submit (pool, &t, &jobs[1], "b");
+	pool_test_submit (pool, &t, &jobs[2], "c");
+	test_run_loop (t.loop);
+
+	for (i = 0; i < 3; i++) {
+		g_assert_no_error (jobs[i].error);
+		g_assert_cmpuint (jobs[i].order, ==, i + 1);
+		g_assert (g_str_has_prefix (jobs[i].secret, jobs[i].name));
+		g_assert_cmpstr (pool_test_job_pid (&jobs[i]), ==, pool_test_job_pid (&jobs[0]));
+	}
+	g_assert_cmpuint (auth_dialog_pool_get_n_helpers (pool), ==, 1);
+
+	for (i = 0; i < 3; i++)
+		pool_test_job_clear (&jobs[i]);
+	auth_dialog_pool_free (pool);
+	g_main_loop_unref (t.loop);
+}
+
+/* A request that waits for the user doesn't hold up the next one, and
+ * dropping it kills the helper that was showing it. */
+static void
+test_auth_dialog_pool_parallel (void)
+{
+	AuthDialogPool *pool = pool_test_new (0, 60000);
+	PoolTest t = { 0 };
+	PoolTestJob hang = { 0 }, a = { 0 };
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.pending = 1;
+	pool_test_submit (pool, &t, &hang, "hang");
+	pool_test_submit (pool, &t, &a, "a");
+	test_run_loop (t.loop);
+
+	g_assert (!hang.done);
+	g_assert (a.done);
+	g_assert_no_error (a.error);
+	g_assert_cmpuint (auth_dialog_pool_get_n_helpers (pool), ==, 2);
+
+	auth_dialog_pool_cancel (pool, hang.job);
+	g_assert_cmpuint (auth_dialog_pool_get_n_helpers (pool), ==, 1);
+	g_assert (!hang.done);
+
+	pool_test_job_clear (&a);
+	auth_dialog_pool_free (pool);
+	g_main_loop_unref (t.loop);
+}
+
+/* A helper that dies fails its request only; the next one gets a new
+ * helper. */
+static void
+test_auth_dialog_pool_die (void)
+{
+	AuthDialogPool *pool = pool_test_new (1, 60000);
+	PoolTest t = { 0 };
+	PoolTestJob die = { 0 }, a = { 0 };
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.pending = 2;
+	pool_test_submit (pool, &t, &die, "die");
+	pool_test_submit (pool, &t, &a, "a");
+	test_run_loop (t.loop);
+
+	g_assert_error (die.error, NM_SECRET_AGENT_ERROR, NM_SECRET_AGENT_ERROR_FAILED);
+	g_assert (!die.secret);
+	g_assert_no_error (a.error);
+	g_assert_cmpuint (a.order, ==, 2);
+	g_assert_cmpuint (auth_dialog_pool_get_n_helpers (pool), ==, 1);
+
+	pool_test_job_clear (&die);
+	pool_test_job_clear (&a);
+	auth_dialog_pool_free (pool);
+	g_main_loop_unref (t.loop);
+}
+
+/* "CANCEL" fails the request as canceled by the user, and the helper
+ * stays around for the next one. */
+static void
+test_auth_dialog_pool_cancel (void)
+{
+	AuthDialogPool *pool = pool_test_new (1, 60000);
+	PoolTest t = { 0 };
+	PoolTestJob cancel = { 0 }, a = { 0 };
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.pending = 2;
+	pool_test_submit (pool, &t, &cancel, "cancel");
+	pool_test_submit (pool, &t, &a, "a");
+	test_run_loop (t.loop);
+
+	g_assert_error (cancel.error, NM_SECRET_AGENT_ERROR, NM_SECRET_AGENT_ERROR_USER_CANCELED);
+	g_assert_no_error (a.error);
+	g_assert (pool_test_log_has ("cancel", pool_test_job_pid (&a)));
+	g_assert_cmpuint (auth_dialog_pool_get_n_helpers (pool), ==, 1);
+
+	pool_test_job_clear (&cancel);
+	pool_test_job_clear (&a);
+	auth_dialog_pool_free (pool);
+	g_main_loop_unref (t.loop);
+}
+
+/* An idle helper is told to quit, and exits by itself. */
+static void
+test_auth_dialog_pool_idle (void)
+{
+	AuthDialogPool *pool = pool_test_new (0, 100);
+	PoolTest t = { 0 };
+	PoolTestJob a = { 0 };
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+	t.pending = 1;
+	pool_test_submit (pool, &t, &a, "a");
+	test_run_loop (t.loop);
+	g_assert_no_error (a.error);
+
+	g_assert (pool_test_wait_helpers (pool, 0));
+	g_assert (pool_test_log_has ("quit", pool_test_job_pid (&a)));
+
+	pool_test_job_clear (&a);
+	auth_dialog_pool_free (pool);
+	g_main_loop_unref (t.loop);
+}
+
+typedef struct {
+	GMainLoop *loop;
+	UtilsSecretsParser *parser;
+	UtilsSecretsParserResult result;
+	char *secret;
+} OneshotTest;
+
+static void
+oneshot_secret_cb (const char *name, const char *value, gpointer user_data)
+{
+	OneshotTest *o = user_data;
+
+	g_assert_cmpstr (name, ==, "password");
+	o->secret = g_strdup (value);
+}
+
+static void
+oneshot_written_cb (GError *error, gpointer user_data)
+{
+	g_assert_no_error (error);
+}
+
+static gboolean
+oneshot_read_cb (int fd, GIOCondition condition, gpointer user_data)
+{
+	OneshotTest *o = user_data;
+	char buf[4096];
+	gssize r;
+	gsize consumed;
+
+	r = read (fd, buf, sizeof (buf));
+	if (r < 0 && errno == EAGAIN)
+		return G_SOURCE_CONTINUE;
+	g_assert_cmpint (r, >=, 0);
+
+	if (r > 0)
+		o->result = utils_secrets_parser_feed (o->parser, buf, r, &consumed);
+	else
+		o->result = utils_secrets_parser_finish (o->parser);
+	if (r > 0 && o->result == UTILS_SECRETS_PARSER_MORE)
+		return G_SOURCE_CONTINUE;
+
+	nm_close (fd);
+	g_main_loop_quit (o->loop);
+	return G_SOURCE_REMOVE;
+}
+
+/* Does what the applet does for plugins without persistent mode: spawn the
+ * dialog, write the request and QUIT, and read the secrets.  The dialog is
+ * left to exit by itself once they're in. */
+static void
+oneshot_request (GMainLoop *loop, const char *name)
+{
+	const char *argv[] = { "/bin/sh", fake_auth_dialog_path, "oneshot", fake_auth_dialog_log, NULL };
+	OneshotTest o = { 0 };
+	AuthDialogWriter *writer;
+	GError *error = NULL;
+	GPid pid;
+	int child_stdin, child_stdout;
+
+	if (!auth_dialog_spawn_argv (argv, &pid, &child_stdin, &child_stdout, &error))
+		g_assert_no_error (error);
+
+	o.loop = loop;
+	o.result = UTILS_SECRETS_PARSER_MORE;
+	o.parser = utils_secrets_parser_new (FALSE, oneshot_secret_cb, &o);
+	g_assert (g_unix_set_fd_nonblocking (child_stdout, TRUE, NULL));
+	g_unix_fd_add (child_stdout, G_IO_IN | G_IO_HUP, oneshot_read_cb, &o);
+
+	writer = auth_dialog_writer_new (child_stdin, TRUE);
+	auth_dialog_writer_add_value (writer, "NAME", name);
+	auth_dialog_writer_add (writer, "DONE\n\nQUIT\n\n", 12);
+	g_assert (auth_dialog_writer_start (writer, oneshot_written_cb, NULL, NULL));
+
+	test_run_loop (loop);
+	g_assert_cmpint (o.result, ==, UTILS_SECRETS_PARSER_DONE);
+	g_assert (g_str_has_prefix (o.secret, name));
+	auth_dialog_release (pid, 5);
+
+	utils_secrets_parser_free (o.parser);
+	g_free (o.secret);
+}
+
+static gboolean
+test_wait_reaped (GPid pid)
+{
+	gint64 end = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+
+	/* A zombie can still be signalled */
+	while (kill (pid, 0) == 0) {
+		if (g_get_monotonic_time () > end)
+			return FALSE;
+		g_main_context_iteration (NULL, TRUE);
+	}
+	return errno == ESRCH;
+}
+
+/* A released auth-dialog is reaped when it exits on the QUIT it was sent,
+ * and killed when it doesn't exit in time. */
+static void
+test_auth_dialog_release (void)
+{
+	const char *argv[] = { "/bin/sh", fake_auth_dialog_path, "oneshot", fake_auth_dialog_log, NULL };
+	const char *stubborn_argv[] = { "/bin/sh", "-c", "read -r line; exec sleep 60", NULL };
+	gs_free char *pid_str = NULL;
+	GError *error = NULL;
+	GPid pid;
+	int child_stdin, child_stdout;
+
+	if (!auth_dialog_spawn_argv (argv, &pid, &child_stdin, &child_stdout, &error))
+		g_assert_no_error (error);
+	g_assert_cmpint (write (child_stdin, "QUIT\n\n", 6), ==, 6);
+	auth_dialog_release (pid, 5);
+	g_assert (test_wait_reaped (pid));
+	pid_str = g_strdup_printf ("%d", (int) pid);
+	g_assert (pool_test_log_has ("quit", pid_str));
+	nm_close (child_stdin);
+	nm_close (child_stdout);
+
+	if (!auth_dialog_spawn_argv (stubborn_argv, &pid, &child_stdin, &child_stdout, &error))
+		g_assert_no_error (error);
+	g_assert_cmpint (write (child_stdin, "QUIT\n\n", 6), ==, 6);
+	auth_dialog_release (pid, 1);
+	g_assert (test_wait_reaped (pid));
+	nm_close (child_stdin);
+	nm_close (child_stdout);
+}
+
+/* Time per request with a persistent helper against an auth-dialog spawned
+ * for each request. Run with "-m perf" for more rounds. */
+static void
+test_auth_dialog_pool_latency (void)
+{
+	guint rounds = g_test_perf () ? 50 : 3;
+	AuthDialogPool *pool = pool_test_new (1, 60000);
+	PoolTest t = { 0 };
+	gdouble persistent, oneshot;
+	guint r;
+
+	t.loop = g_main_loop_new (NULL, FALSE);
+
+	/* Don't count the start of the first helper */
+	{
+		PoolTestJob j = { 0 };
+
+		t.pending = 1;
+		pool_test_submit (pool, &t, &j, "warmup");
+		test_run_loop (t.loop);
+		g_assert_no_error (j.error);
+		pool_test_job_clear (&j);
+	}
+
+	g_test_timer_start ();
+	for (r = 0; r < rounds; r++) {
+		PoolTestJob j = { 0 };
+
+		t.pending = 1;
+		pool_test_submit (pool, &t, &j, "a");
+		test_run_loop (t.loop);
+		g_assert_no_error (j.error);
+		g_assert (g_str_has_prefix (j.secret, "a-"));
+		pool_test_job_clear (&j);
+	}
+	persistent = g_test_timer_elapsed () / rounds;
+	g_assert_cmpuint (auth_dialog_pool_get_n_helpers (pool), ==, 1);
+
+	g_test_timer_start ();
+	for (r = 0; r < rounds; r++)
+		oneshot_request (t.loop, "a");
+	oneshot = g_test_timer_elapsed () / rounds;
+
+	if (g_test_perf ()) {
+		g_test_minimized_result (persistent, "persistent auth-dialog: %.3f ms per request", persistent * 1e3);
+		g_test_minimized_result (oneshot, "auth-dialog per request: %.3f ms per request", oneshot * 1e3);
+	}
+
+	auth_dialog_pool_free (pool);
+	g_main_loop_unref (t.loop);
+}
+
 NMTST_DEFINE ();
 
 int
@@ -488,9 +1651,39 @@ main (int argc, char **argv)
 	g_test_add_data_func ("/ap_hash/foobar_asdf11/adhoc_wpa_rsn", data,
 	                      (GTestDataFunc) test_ap_hash_foobar_asdf11_adhoc_wpa_rsn);
 
+	/* Test that the binary key groups like the hash */
+	g_test_add_func ("/ap_key/equivalence", test_ap_key_equivalence);
+
+	g_test_add_data_func ("/ap_hash/grouping/10", GUINT_TO_POINTER (10), test_ap_hash_grouping);
+	g_test_add_data_func ("/ap_hash/grouping/100", GUINT_TO_POINTER (100), test_ap_hash_grouping);
+	g_test_add_data_func ("/ap_hash/grouping/1000", GUINT_TO_POINTER (1000), test_ap_hash_grouping);
+
+	g_test_add_func ("/secrets_parser/splits", test_secrets_parser_splits);
+	g_test_add_func ("/secrets_parser/random", test_secrets_parser_random);
+	g_test_add_func ("/secrets_parser/long", test_secrets_parser_long);
+
+	g_test_add_data_func ("/batch/refilter/1000", GUINT_TO_POINTER (1000), test_batch_refilter);
+	g_test_add_data_func ("/batch/refilter/5000", GUINT_TO_POINTER (5000), test_batch_refilter);
+
+	/* As in the applet, a reader going away shows up as EPIPE */
+	signal (SIGPIPE, SIG_IGN);
+	g_test_add_func ("/auth_dialog/writer/pipe", test_auth_dialog_writer_pipe);
+	g_test_add_func ("/auth_dialog/writer/in_place", test_auth_dialog_writer_in_place);
+	g_test_add_func ("/auth_dialog/writer/epipe", test_auth_dialog_writer_epipe);
+
+	fake_auth_dialog_create ();
+	g_test_add_func ("/auth_dialog/pool/queue", test_auth_dialog_pool_queue);
+	g_test_add_func ("/auth_dialog/pool/parallel", test_auth_dialog_pool_parallel);
+	g_test_add_func ("/auth_dialog/pool/die", test_auth_dialog_pool_die);
+	g_test_add_func ("/auth_dialog/pool/cancel", test_auth_dialog_pool_cancel);
+	g_test_add_func ("/auth_dialog/pool/idle", test_auth_dialog_pool_idle);
+	g_test_add_func ("/auth_dialog/pool/latency", test_auth_dialog_pool_latency);
+	g_test_add_func ("/auth_dialog/release", test_auth_dialog_release);
+
 	result = g_test_run ();
 
 	test_data_free (data);
+	fake_auth_dialog_remove ();
 
 	return result;
 }
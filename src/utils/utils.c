@@ -53,48 +53,195 @@ utils_ether_addr_valid (const struct ether_addr *test_addr)
 	return TRUE;
 }
 
-char *
-utils_hash_ap (GBytes *ssid,
-               NM80211Mode mode,
+static guint8
+ap_hash_class (NM80211Mode mode,
                guint32 flags,
                guint32 wpa_flags,
                guint32 rsn_flags)
 {
-	unsigned char input[66];
-
-	memset (&input[0], 0, sizeof (input));
-
-	if (ssid)
-		memcpy (input, g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid));
+	guint8 class = 0;
 
 	if (mode == NM_802_11_MODE_INFRA)
-		input[32] |= (1 << 0);
+		class |= (1 << 0);
 	else if (mode == NM_802_11_MODE_ADHOC)
-		input[32] |= (1 << 1);
+		class |= (1 << 1);
 	else
-		input[32] |= (1 << 2);
+		class |= (1 << 2);
 
 	/* Separate out no encryption, WEP-only, and WPA-capable */
 	if (  !(flags & NM_802_11_AP_FLAGS_PRIVACY)
 	    && (wpa_flags == NM_802_11_AP_SEC_NONE)
 	    && (rsn_flags == NM_802_11_AP_SEC_NONE))
-		input[32] |= (1 << 3);
+		class |= (1 << 3);
 	else if (   (flags & NM_802_11_AP_FLAGS_PRIVACY)
 	         && (wpa_flags == NM_802_11_AP_SEC_NONE)
 	         && (rsn_flags == NM_802_11_AP_SEC_NONE))
-		input[32] |= (1 << 4);
+		class |= (1 << 4);
 	else if (   !(flags & NM_802_11_AP_FLAGS_PRIVACY)
 	         &&  (wpa_flags != NM_802_11_AP_SEC_NONE)
 	         &&  (rsn_flags != NM_802_11_AP_SEC_NONE))
-		input[32] |= (1 << 5);
+		class |= (1 << 5);
 	else
-		input[32] |= (1 << 6);
+		class |= (1 << 6);
+
+	return class;
+}
+
+char *
+utils_hash_ap (GBytes *ssid,
+               NM80211Mode mode,
+               guint32 flags,
+               guint32 wpa_flags,
+               guint32 rsn_flags)
+{
+	unsigned char input[66];
+
+	memset (&input[0], 0, sizeof (input));
+
+	if (ssid)
+		memcpy (input, g_bytes_get_data (ssid, NULL), MIN (g_bytes_get_size (ssid), 32));
+
+	input[32] = ap_hash_class (mode, flags, wpa_flags, rsn_flags);
 
 	/* duplicate it */
 	memcpy (&input[33], &input[0], 32);
 	return g_compute_checksum_for_data (G_CHECKSUM_MD5, input, sizeof (input));
 }
 
+static inline guint64
+ap_key_mix (guint64 h, guint64 v)
+{
+	/* splitmix64 finalizer */
+	h ^= v;
+	h ^= h >> 30;
+	h *= G_GUINT64_CONSTANT (0xbf58476d1ce4e5b9);
+	h ^= h >> 27;
+	h *= G_GUINT64_CONSTANT (0x94d049bb133111eb);
+	h ^= h >> 31;
+	return h;
+}
+
+/*
+ * utils_ap_key_init
+ *
+ * Fills @key with a compact identity of the network an AP belongs to.
+ * Two APs get equal keys exactly when utils_hash_ap() gives them equal
+ * hashes, but the key is much cheaper to compute and compare.  The seeds
+ * are picked randomly once per process so that the keys can't be made
+ * to collide on purpose by choosing SSIDs.
+ */
+void
+utils_ap_key_init (UtilsApKey *key,
+                   GBytes *ssid,
+                   NM80211Mode mode,
+                   guint32 flags,
+                   guint32 wpa_flags,
+                   guint32 rsn_flags)
+{
+	static guint64 seeds[2];
+	static gsize seeds_initialized = 0;
+	guint64 words[4] = { 0, 0, 0, 0 };
+	guint64 class;
+	guint i;
+
+	g_return_if_fail (key);
+
+	if (g_once_init_enter (&seeds_initialized)) {
+		seeds[0] = ((guint64) g_random_int () << 32) | g_random_int ();
+		seeds[1] = ((guint64) g_random_int () << 32) | g_random_int ();
+		g_once_init_leave (&seeds_initialized, 1);
+	}
+
+	/* Like utils_hash_ap(), the SSID is treated as 32 zero-padded bytes */
+	if (ssid)
+		memcpy (words, g_bytes_get_data (ssid, NULL), MIN (g_bytes_get_size (ssid), sizeof (words)));
+	class = ap_hash_class (mode, flags, wpa_flags, rsn_flags);
+
+	key->v[0] = seeds[0];
+	key->v[1] = seeds[1];
+	for (i = 0; i < G_N_ELEMENTS (words); i++) {
+		key->v[0] = ap_key_mix (key->v[0], words[i]);
+		key->v[1] = ap_key_mix (key->v[1], words[i] ^ key->v[0]);
+	}
+	key->v[0] = ap_key_mix (key->v[0], class);
+	key->v[1] = ap_key_mix (key->v[1], class ^ key->v[0]);
+}
+
+guint
+utils_ap_key_hash (gconstpointer key)
+{
+	const UtilsApKey *k = key;
+
+	return (guint) (k->v[0] ^ (k->v[0] >> 32));
+}
+
+gboolean
+utils_ap_key_equal (gconstpointer a, gconstpointer b)
+{
+	return memcmp (a, b, sizeof (UtilsApKey)) == 0;
+}
+
+static void
+ap_key_free (gpointer key)
+{
+	g_slice_free (UtilsApKey, key);
+}
+
+/*
+ * utils_ap_groups_new
+ *
+ * Creates an index of the networks seen in a scan list, keyed by
+ * #UtilsApKey.  @group_destroy is called on the groups when they are
+ * removed from the index.
+ */
+GHashTable *
+utils_ap_groups_new (GDestroyNotify group_destroy)
+{
+	return g_hash_table_new_full (utils_ap_key_hash, utils_ap_key_equal,
+	                              ap_key_free, group_destroy);
+}
+
+void
+utils_ap_groups_insert (GHashTable *groups,
+                        const UtilsApKey *key,
+                        gpointer group)
+{
+	g_hash_table_insert (groups, g_slice_dup (UtilsApKey, key), group);
+}
+
+/*
+ * utils_ap_groups_add
+ *
+ * Adds @ap to the group of the network @key in @groups through @add_func,
+ * or starts a new group for it with @new_func if there isn't one yet.
+ *
+ * Returns: the new group, or %NULL if @ap was added to an existing one
+ */
+gpointer
+utils_ap_groups_add (GHashTable *groups,
+                     gpointer ap,
+                     const UtilsApKey *key,
+                     UtilsApGroupNewFunc new_func,
+                     UtilsApGroupAddFunc add_func,
+                     gpointer user_data)
+{
+	gpointer group;
+
+	g_return_val_if_fail (groups, NULL);
+	g_return_val_if_fail (key, NULL);
+
+	group = g_hash_table_lookup (groups, key);
+	if (group) {
+		add_func (group, ap, user_data);
+		return NULL;
+	}
+
+	group = new_func (ap, key, user_data);
+	if (group)
+		utils_ap_groups_insert (groups, key, group);
+	return group;
+}
+
 typedef struct {
 	const char *tag;
 	const char *replacement;
@@ -547,3 +694,248 @@ utils_key_filter (void)
 
 	return filter;
 }
+
+/*
+ * UtilsSecretsParser
+ *
+ * Incremental parser for the secrets an auth-dialog prints on stdout:
+ * name and value lines in pairs, terminated by an empty line where a name
+ * is expected.  With @with_status, the pairs are preceded by a status line
+ * that is either "OK" or "CANCEL".  Input can be fed in chunks split at any
+ * byte; only the line being read is buffered, and each secret is handed to
+ * the callback as soon as its value line is complete.
+ */
+struct _UtilsSecretsParser {
+	UtilsSecretsFunc func;
+	gpointer user_data;
+	gboolean with_status;
+	gboolean status_seen;
+	GString *line;
+	char *name;
+	UtilsSecretsParserResult result;
+};
+
+UtilsSecretsParser *
+utils_secrets_parser_new (gboolean with_status,
+                          UtilsSecretsFunc func,
+                          gpointer user_data)
+{
+	UtilsSecretsParser *parser;
+
+	g_return_val_if_fail (func, NULL);
+
+	parser = g_slice_new0 (UtilsSecretsParser);
+	parser->func = func;
+	parser->user_data = user_data;
+	parser->with_status = with_status;
+	parser->line = g_string_sized_new (128);
+	parser->result = UTILS_SECRETS_PARSER_MORE;
+	return parser;
+}
+
+static void
+secrets_parser_clear_line (UtilsSecretsParser *parser)
+{
+	memset (parser->line->str, 0, parser->line->len);
+	g_string_truncate (parser->line, 0);
+}
+
+static void
+secrets_parser_clear_name (UtilsSecretsParser *parser)
+{
+	if (parser->name) {
+		memset (parser->name, 0, strlen (parser->name));
+		nm_clear_g_free (&parser->name);
+	}
+}
+
+static UtilsSecretsParserResult
+secrets_parser_line (UtilsSecretsParser *parser)
+{
+	const char *line = parser->line->str;
+
+	if (parser->with_status && !parser->status_seen) {
+		parser->status_seen = TRUE;
+		if (nm_streq (line, "OK"))
+			return UTILS_SECRETS_PARSER_MORE;
+		if (nm_streq (line, "CANCEL"))
+			return UTILS_SECRETS_PARSER_CANCELED;
+		return UTILS_SECRETS_PARSER_ERROR;
+	}
+
+	if (!parser->name) {
+		if (!line[0])
+			return UTILS_SECRETS_PARSER_DONE;
+		parser->name = g_strdup (line);
+		return UTILS_SECRETS_PARSER_MORE;
+	}
+
+	parser->func (parser->name, line, parser->user_data);
+	secrets_parser_clear_name (parser);
+	return UTILS_SECRETS_PARSER_MORE;
+}
+
+/*
+ * utils_secrets_parser_feed
+ *
+ * Parses the next @len bytes of output.  Once the response is complete the
+ * result other than UTILS_SECRETS_PARSER_MORE is returned, and the bytes
+ * following it are left unconsumed; @out_consumed tells how many were used.
+ */
+UtilsSecretsParserResult
+utils_secrets_parser_feed (UtilsSecretsParser *parser,
+                           const char *data,
+                           gsize len,
+                           gsize *out_consumed)
+{
+	const char *p = data;
+	const char *end = data + len;
+	const char *nl;
+
+	g_return_val_if_fail (parser, UTILS_SECRETS_PARSER_ERROR);
+
+	while (parser->result == UTILS_SECRETS_PARSER_MORE && p < end) {
+		nl = memchr (p, '\n', end - p);
+		if (!nl) {
+			g_string_append_len (parser->line, p, end - p);
+			p = end;
+			break;
+		}
+
+		g_string_append_len (parser->line, p, nl - p);
+		p = nl + 1;
+		parser->result = secrets_parser_line (parser);
+		secrets_parser_clear_line (parser);
+	}
+
+	NM_SET_OUT (out_consumed, p - data);
+	return parser->result;
+}
+
+/*
+ * utils_secrets_parser_finish
+ *
+ * To be called at end of input.  Without a status line, output that ends
+ * without the terminating empty line is accepted with the secrets read
+ * up to that point, the same way it was before the parser was incremental.
+ */
+UtilsSecretsParserResult
+utils_secrets_parser_finish (UtilsSecretsParser *parser)
+{
+	g_return_val_if_fail (parser, UTILS_SECRETS_PARSER_ERROR);
+
+	if (parser->result != UTILS_SECRETS_PARSER_MORE)
+		return parser->result;
+
+	if (parser->line->len) {
+		parser->result = secrets_parser_line (parser);
+		secrets_parser_clear_line (parser);
+		if (parser->result != UTILS_SECRETS_PARSER_MORE)
+			return parser->result;
+	}
+
+	secrets_parser_clear_name (parser);
+	if (parser->with_status && !parser->status_seen)
+		parser->result = UTILS_SECRETS_PARSER_ERROR;
+	else
+		parser->result = UTILS_SECRETS_PARSER_DONE;
+	return parser->result;
+}
+
+void
+utils_secrets_parser_reset (UtilsSecretsParser *parser)
+{
+	g_return_if_fail (parser);
+
+	secrets_parser_clear_line (parser);
+	secrets_parser_clear_name (parser);
+	parser->status_seen = FALSE;
+	parser->result = UTILS_SECRETS_PARSER_MORE;
+}
+
+void
+utils_secrets_parser_free (UtilsSecretsParser *parser)
+{
+	if (!parser)
+		return;
+
+	utils_secrets_parser_reset (parser);
+	g_string_free (parser->line, TRUE);
+	g_slice_free (UtilsSecretsParser, parser);
+}
+
+/*
+ * UtilsBatch
+ *
+ * Runs a function once for any number of changes made within one main loop
+ * iteration, such as refiltering a tree model after rows were added or
+ * removed one by one.  The runs are counted, so that the batching can be
+ * checked.
+ */
+struct _UtilsBatch {
+	UtilsBatchFunc func;
+	gpointer user_data;
+	guint idle_id;
+	guint n_runs;
+};
+
+UtilsBatch *
+utils_batch_new (UtilsBatchFunc func, gpointer user_data)
+{
+	UtilsBatch *batch;
+
+	g_return_val_if_fail (func, NULL);
+
+	batch = g_slice_new0 (UtilsBatch);
+	batch->func = func;
+	batch->user_data = user_data;
+	return batch;
+}
+
+static gboolean
+batch_idle_cb (gpointer user_data)
+{
+	UtilsBatch *batch = user_data;
+
+	batch->idle_id = 0;
+	batch->n_runs++;
+	batch->func (batch->user_data);
+	return G_SOURCE_REMOVE;
+}
+
+void
+utils_batch_schedule (UtilsBatch *batch)
+{
+	g_return_if_fail (batch);
+
+	if (!batch->idle_id)
+		batch->idle_id = g_idle_add (batch_idle_cb, batch);
+}
+
+/* Runs the function right away, taking the place of a scheduled run */
+void
+utils_batch_run_now (UtilsBatch *batch)
+{
+	g_return_if_fail (batch);
+
+	nm_clear_g_source (&batch->idle_id);
+	batch_idle_cb (batch);
+}
+
+guint
+utils_batch_get_n_runs (UtilsBatch *batch)
+{
+	g_return_val_if_fail (batch, 0);
+
+	return batch->n_runs;
+}
+
+void
+utils_batch_free (UtilsBatch *batch)
+{
+	if (!batch)
+		return;
+
+	nm_clear_g_source (&batch->idle_id);
+	g_slice_free (UtilsBatch, batch);
+}
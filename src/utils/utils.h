@@ -19,6 +19,41 @@ char *utils_hash_ap (GBytes *ssid,
                      guint32 wpa_flags,
                      guint32 rsn_flags);
 
+typedef struct {
+	guint64 v[2];
+} UtilsApKey;
+
+void utils_ap_key_init (UtilsApKey *key,
+                        GBytes *ssid,
+                        NM80211Mode mode,
+                        guint32 flags,
+                        guint32 wpa_flags,
+                        guint32 rsn_flags);
+
+guint utils_ap_key_hash (gconstpointer key);
+
+gboolean utils_ap_key_equal (gconstpointer a, gconstpointer b);
+
+typedef gpointer (*UtilsApGroupNewFunc) (gpointer ap,
+                                         const UtilsApKey *key,
+                                         gpointer user_data);
+typedef void (*UtilsApGroupAddFunc) (gpointer group,
+                                     gpointer ap,
+                                     gpointer user_data);
+
+GHashTable *utils_ap_groups_new (GDestroyNotify group_destroy);
+
+void utils_ap_groups_insert (GHashTable *groups,
+                             const UtilsApKey *key,
+                             gpointer group);
+
+gpointer utils_ap_groups_add (GHashTable *groups,
+                              gpointer ap,
+                              const UtilsApKey *key,
+                              UtilsApGroupNewFunc new_func,
+                              UtilsApGroupAddFunc add_func,
+                              gpointer user_data);
+
 char *utils_escape_notify_message (const char *src);
 
 char *utils_create_mobile_connection_id (const char *provider,
@@ -88,4 +123,46 @@ GtkFileFilter *utils_cert_filter (void);
 
 GtkFileFilter *utils_key_filter (void);
 
+typedef enum {
+	UTILS_SECRETS_PARSER_MORE,
+	UTILS_SECRETS_PARSER_DONE,
+	UTILS_SECRETS_PARSER_CANCELED,
+	UTILS_SECRETS_PARSER_ERROR,
+} UtilsSecretsParserResult;
+
+typedef void (*UtilsSecretsFunc) (const char *name,
+                                  const char *value,
+                                  gpointer user_data);
+
+typedef struct _UtilsSecretsParser UtilsSecretsParser;
+
+UtilsSecretsParser *utils_secrets_parser_new (gboolean with_status,
+                                              UtilsSecretsFunc func,
+                                              gpointer user_data);
+
+UtilsSecretsParserResult utils_secrets_parser_feed (UtilsSecretsParser *parser,
+                                                    const char *data,
+                                                    gsize len,
+                                                    gsize *out_consumed);
+
+UtilsSecretsParserResult utils_secrets_parser_finish (UtilsSecretsParser *parser);
+
+void utils_secrets_parser_reset (UtilsSecretsParser *parser);
+
+void utils_secrets_parser_free (UtilsSecretsParser *parser);
+
+typedef void (*UtilsBatchFunc) (gpointer user_data);
+
+typedef struct _UtilsBatch UtilsBatch;
+
+UtilsBatch *utils_batch_new (UtilsBatchFunc func, gpointer user_data);
+
+void utils_batch_schedule (UtilsBatch *batch);
+
+void utils_batch_run_now (UtilsBatch *batch);
+
+guint utils_batch_get_n_runs (UtilsBatch *batch);
+
+void utils_batch_free (UtilsBatch *batch);
+
 #endif /* UTILS_H */